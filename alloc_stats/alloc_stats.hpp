@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#ifdef ALLOC_STATS
+#include <mutex>
+#endif
+
+struct AllocCounters {
+  size_t allocations = 0;
+  size_t bytes = 0;
+  size_t reallocations = 0;
+  size_t copies = 0;
+};
+
+// Per (type, operation) counters. Built with -DALLOC_STATS the hooks below
+// record into a global table; without it they expand to nothing and
+// Snapshot() is always empty.
+class AllocStats {
+ public:
+  using Key = std::pair<std::string, std::string>;
+  using Table = std::map<Key, AllocCounters>;
+
+#ifdef ALLOC_STATS
+  // Events are charged to the outermost open scope on this thread, so a
+  // Split is billed for the Strings it constructs. Events outside any scope
+  // go to (type, "other").
+  class Scope {
+   public:
+    Scope(const char* type, const char* operation) : owner_(type_ == nullptr) {
+      if (owner_) {
+        type_ = type;
+        operation_ = operation;
+      }
+    }
+
+    Scope(const Scope&) = delete;
+
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope() {
+      if (owner_) {
+        type_ = nullptr;
+        operation_ = nullptr;
+      }
+    }
+
+   private:
+    bool owner_;
+  };
+
+  static void RecordAllocation(const char* type, size_t bytes) {
+    Record(type, 1, bytes, 0, 0);
+  }
+
+  static void RecordReallocation(const char* type) {
+    Record(type, 0, 0, 1, 0);
+  }
+
+  static void RecordCopy(const char* type) { Record(type, 0, 0, 0, 1); }
+
+  static Table Snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return table_;
+  }
+
+  static AllocCounters Get(const char* type, const char* operation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = table_.find(Key(type, operation));
+    return it == table_.end() ? AllocCounters() : it->second;
+  }
+
+  static void Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    table_.clear();
+  }
+
+ private:
+  static inline thread_local const char* type_ = nullptr;
+  static inline thread_local const char* operation_ = nullptr;
+  static inline std::mutex mutex_;
+  static inline Table table_;
+
+  static void Record(const char* type, size_t allocations, size_t bytes,
+                     size_t reallocations, size_t copies) {
+    Key key = type_ == nullptr ? Key(type, "other") : Key(type_, operation_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    AllocCounters& counters = table_[key];
+    counters.allocations += allocations;
+    counters.bytes += bytes;
+    counters.reallocations += reallocations;
+    counters.copies += copies;
+  }
+#else
+  static Table Snapshot() { return Table(); }
+
+  static AllocCounters Get(const char*, const char*) { return AllocCounters(); }
+
+  static void Reset() {}
+#endif
+};
+
+#ifdef ALLOC_STATS
+// Counts the allocations of standard containers under the name Type.
+template <typename T, const char* Type>
+class StatsAllocator {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = StatsAllocator<U, Type>;
+  };
+
+  StatsAllocator() = default;
+
+  template <typename U>
+  StatsAllocator(const StatsAllocator<U, Type>&) {}
+
+  T* allocate(size_t n) {
+    AllocStats::RecordAllocation(Type, n * sizeof(T));
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, size_t n) { std::allocator<T>().deallocate(ptr, n); }
+
+  friend bool operator==(const StatsAllocator&, const StatsAllocator&) {
+    return true;
+  }
+
+  friend bool operator!=(const StatsAllocator&, const StatsAllocator&) {
+    return false;
+  }
+};
+
+#define ALLOC_STATS_SCOPE(type, operation) \
+  AllocStats::Scope alloc_stats_scope(type, operation)
+#define ALLOC_STATS_ALLOCATION(type, bytes) \
+  AllocStats::RecordAllocation(type, bytes)
+#define ALLOC_STATS_REALLOCATION(type) AllocStats::RecordReallocation(type)
+#define ALLOC_STATS_COPY(type) AllocStats::RecordCopy(type)
+#else
+template <typename T, const char* Type>
+using StatsAllocator = std::allocator<T>;
+
+#define ALLOC_STATS_SCOPE(type, operation)
+#define ALLOC_STATS_ALLOCATION(type, bytes)
+#define ALLOC_STATS_REALLOCATION(type)
+#define ALLOC_STATS_COPY(type)
+#endif
@@ -5,6 +5,7 @@ BigInt::BigInt() = default;
 BigInt::BigInt(int64_t num) : BigInt(std::to_string(num)) {}
 
 BigInt::BigInt(const std::string& str) {
+  ALLOC_STATS_SCOPE("BigInt", "Parse");
   if (str[0] == '-' && str[1] == '0') {
     number_.push_back(str[1] - '0');
     return;
@@ -21,19 +22,36 @@ BigInt::BigInt(const std::string& str) {
   }
 }
 
-BigInt::BigInt(const std::vector<int>& arr, int sn) : number_(arr), sign_(sn) {}
+BigInt::BigInt(const std::vector<int>& arr, int sn)
+    : number_(arr.begin(), arr.end()), sign_(sn) {}
 
 BigInt::BigInt(const BigInt& other) {
+  ALLOC_STATS_SCOPE("BigInt", "Copy");
+  ALLOC_STATS_COPY("BigInt");
   number_ = other.number_;
   sign_ = other.sign_;
 }
 
-BigInt& BigInt::operator=(const BigInt&) = default;
+BigInt& BigInt::operator=(const BigInt& other) {
+  ALLOC_STATS_SCOPE("BigInt", "Copy");
+  ALLOC_STATS_COPY("BigInt");
+  number_ = other.number_;
+  sign_ = other.sign_;
+  return *this;
+}
+
+BigInt BigInt::FromDigits(Digits digits, int sn) {
+  BigInt res;
+  res.number_ = std::move(digits);
+  res.sign_ = sn;
+  return res;
+}
 
 BigInt::~BigInt() = default;
 
 BigInt BigInt::Add(const BigInt& first, const BigInt& second, bool is_neg) {
-  std::vector<int> result;
+  ALLOC_STATS_SCOPE("BigInt", "Add");
+  Digits result;
   int carry = 0;
   int min_of_two = std::min(first.number_.size(), second.number_.size());
   int max_of_two = std::max(first.number_.size(), second.number_.size());
@@ -56,7 +74,7 @@ BigInt BigInt::Add(const BigInt& first, const BigInt& second, bool is_neg) {
   if (carry != 0) {
     result.push_back(carry);
   }
-  BigInt sum_of_bigint(result);
+  BigInt sum_of_bigint = FromDigits(std::move(result));
   if (is_neg) {
     sum_of_bigint.sign_ = -1;
   }
@@ -93,7 +111,8 @@ BigInt& BigInt::operator+=(const BigInt& other) {
 
 BigInt BigInt::Substract(const BigInt& first, const BigInt& second,
                          bool is_neg) {
-  std::vector<int> result;
+  ALLOC_STATS_SCOPE("BigInt", "Substract");
+  Digits result;
   int carry = 0;
   for (size_t i = 0; i < second.number_.size(); ++i) {
     int cur_diff = first.number_[i] - second.number_[i] - carry;
@@ -117,7 +136,7 @@ BigInt BigInt::Substract(const BigInt& first, const BigInt& second,
   while (result.size() > 1 && result.back() == 0) {
     result.pop_back();
   }
-  BigInt diff_of_bigint(result);
+  BigInt diff_of_bigint = FromDigits(std::move(result));
   if (is_neg) {
     diff_of_bigint.sign_ = -1;
   }
@@ -153,7 +172,8 @@ BigInt& BigInt::operator-=(const BigInt& other) {
 }
 
 BigInt BigInt::Mult(const BigInt& first, const BigInt& second) {
-  std::vector<int> res(first.number_.size() * second.number_.size() + 1, 0);
+  ALLOC_STATS_SCOPE("BigInt", "Mult");
+  Digits res(first.number_.size() * second.number_.size() + 1, 0);
   for (size_t i = 0; i < first.number_.size(); ++i) {
     int carry = 0;
     for (size_t j = 0; j < second.number_.size(); ++j) {
@@ -171,7 +191,7 @@ BigInt BigInt::Mult(const BigInt& first, const BigInt& second) {
   while (res.size() > 1 && res.back() == 0) {
     res.pop_back();
   }
-  BigInt mult_of_bigint(res);
+  BigInt mult_of_bigint = FromDigits(std::move(res));
   if ((first.number_[0] == 0 && first.number_.size() == 1) ||
       (first.number_[0] == 0 && first.number_.size() == 1)) {
     return mult_of_bigint;
@@ -189,11 +209,11 @@ BigInt operator*(const BigInt& a, const BigInt& b) {
 }
 
 BigInt BigInt::Divide(const BigInt& first, const BigInt& second) {
+  ALLOC_STATS_SCOPE("BigInt", "Divide");
   int min_of_two = std::min(first.number_.size(), second.number_.size());
   int max_of_two = std::max(first.number_.size(), second.number_.size());
-  std::vector<int> res(max_of_two - min_of_two + 1, 0);
-  BigInt div_of_bigint(res);
-  for (int i = res.size() - 1; i >= 0; --i) {
+  BigInt div_of_bigint = FromDigits(Digits(max_of_two - min_of_two + 1, 0));
+  for (int i = div_of_bigint.number_.size() - 1; i >= 0; --i) {
     while (IsLess(second * div_of_bigint, first)) {
       div_of_bigint.number_[i]++;
     }
@@ -219,6 +239,7 @@ BigInt BigInt::operator/(const BigInt& b) const {
 }
 
 BigInt BigInt::Mod(const BigInt& first, const BigInt& second) {
+  ALLOC_STATS_SCOPE("BigInt", "Mod");
   BigInt div = (first / second);
   BigInt mod = first - div * second;
   if (first.sign_ == 1 && second.sign_ == 1) {
@@ -280,9 +301,9 @@ BigInt BigInt::operator--(int) {
 
 BigInt BigInt::operator-() const {
   if (number_.size() == 1 && number_[0] == 0) {
-    return BigInt(number_);
+    return FromDigits(number_);
   }
-  return BigInt(number_, -1);
+  return FromDigits(number_, -1);
 }
 
 bool IsLess(const BigInt& first, const BigInt& second) {
@@ -4,8 +4,12 @@
 #include <string>
 #include <vector>
 
+#include "../alloc_stats/alloc_stats.hpp"
+
 const int kBase = 10;
 
+inline constexpr char kBigIntStats[] = "BigInt";
+
 class BigInt {
  public:
   BigInt();
@@ -83,6 +87,10 @@ class BigInt {
   friend std::ostream& operator<<(std::ostream&, const BigInt&);
 
  private:
-  std::vector<int> number_;
+  using Digits = std::vector<int, StatsAllocator<int, kBigIntStats>>;
+
+  static BigInt FromDigits(Digits, int sn = 1);
+
+  Digits number_;
   int sign_ = 1;
 };
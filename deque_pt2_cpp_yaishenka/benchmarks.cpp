@@ -0,0 +1,360 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "deque.hpp"
+#include "mpmc_deque.hpp"
+#include "ring_deque.hpp"
+#include "spsc_deque.hpp"
+#include "work_stealing_deque.hpp"
+
+namespace {
+
+const int64_t kMinElements = 1 << 10;
+const int64_t kMaxElements = 1 << 24;
+const size_t kProbes = 1 << 12;
+const size_t kHandoffs = 1 << 20;
+const int64_t kMaxSmallQueue = 256;
+const size_t kBatch = 64;
+const int kMaxThreads = 16;
+const size_t kBoundedCapacity = 1 << 16;
+const size_t kReduceElements = 1 << 22;
+const size_t kGrain = 1 << 12;
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(16)->Range(kMinElements, kMaxElements);
+}
+
+// A deque whose logical start is in the middle of a block, so that indexing
+// crosses blocks the way a queue that has been popped from does.
+Deque<uint64_t> MakeDeque(size_t size) {
+  Deque<uint64_t> deque;
+  for (size_t i = 0; i < size; ++i) {
+    deque.push_back(i);
+  }
+  for (size_t i = 0; i < size / 3; ++i) {
+    deque.push_front(i);
+  }
+  return deque;
+}
+
+std::vector<size_t> MakeProbes(size_t size) {
+  std::vector<size_t> probes(kProbes);
+  uint64_t state = 88172645463325252ull;
+  for (size_t& probe : probes) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    probe = state % size;
+  }
+  return probes;
+}
+
+// A range of grains [first, last) packed into one word, so that tasks fit
+// in a WorkStealingDeque slot.
+uint64_t PackTask(uint64_t first, uint64_t last) { return first << 32 | last; }
+
+// Parallel sum on `threads` work-stealing workers. A worker splits its
+// range in halves, keeps the left one and pushes the right one, which idle
+// workers steal; the calling thread is worker 0.
+uint64_t ParallelSum(const std::vector<uint64_t>& data, int threads) {
+  size_t grains = (data.size() + kGrain - 1) / kGrain;
+  std::vector<std::unique_ptr<WorkStealingDeque<uint64_t>>> deques;
+  for (int i = 0; i < threads; ++i) {
+    deques.push_back(std::make_unique<WorkStealingDeque<uint64_t>>());
+  }
+  std::atomic<size_t> remaining{grains};
+  std::atomic<uint64_t> total{0};
+
+  auto worker = [&](int id) {
+    WorkStealingDeque<uint64_t>& own = *deques[id];
+    uint64_t sum = 0;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+      std::optional<uint64_t> task = own.pop();
+      for (int i = 1; !task && i < threads; ++i) {
+        task = deques[(id + i) % threads]->steal();
+      }
+      if (!task) {
+        std::this_thread::yield();
+        continue;
+      }
+      uint64_t first = *task >> 32;
+      uint64_t last = *task & 0xffffffff;
+      while (last - first > 1) {
+        uint64_t middle = first + (last - first) / 2;
+        own.push(PackTask(middle, last));
+        last = middle;
+      }
+      auto begin = data.begin() + first * kGrain;
+      auto end = data.begin() + std::min(last * kGrain, data.size());
+      sum = std::accumulate(begin, end, sum);
+      remaining.fetch_sub(1, std::memory_order_release);
+    }
+    total.fetch_add(sum, std::memory_order_relaxed);
+  };
+
+  deques[0]->push(PackTask(0, grains));
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threads; ++i) {
+    workers.emplace_back(worker, i);
+  }
+  worker(0);
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+  return total.load();
+}
+
+}  // namespace
+
+static void BM_RandomIndex(benchmark::State& state) {
+  Deque<uint64_t> deque = MakeDeque(state.range(0));
+  std::vector<size_t> probes = MakeProbes(deque.size());
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (size_t probe : probes) {
+      sum += deque[probe];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kProbes);
+}
+BENCHMARK(BM_RandomIndex)->Apply(Sizes);
+
+static void BM_RandomAt(benchmark::State& state) {
+  Deque<uint64_t> deque = MakeDeque(state.range(0));
+  std::vector<size_t> probes = MakeProbes(deque.size());
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (size_t probe : probes) {
+      sum += deque.at(probe);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kProbes);
+}
+BENCHMARK(BM_RandomAt)->Apply(Sizes);
+
+static void BM_RandomIterator(benchmark::State& state) {
+  Deque<uint64_t> deque = MakeDeque(state.range(0));
+  std::vector<size_t> probes = MakeProbes(deque.size());
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    auto begin = deque.begin();
+    for (size_t probe : probes) {
+      sum += *(begin + probe);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kProbes);
+}
+BENCHMARK(BM_RandomIterator)->Apply(Sizes);
+
+static void BM_SumIterator(benchmark::State& state) {
+  Deque<uint64_t> deque = MakeDeque(state.range(0));
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (auto iter = deque.begin(); iter != deque.end(); ++iter) {
+      sum += *iter;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * deque.size());
+}
+BENCHMARK(BM_SumIterator)->Apply(Sizes);
+
+static void BM_SumSegmented(benchmark::State& state) {
+  Deque<uint64_t> deque = MakeDeque(state.range(0));
+  for (auto _ : state) {
+    uint64_t sum = accumulate(deque.begin(), deque.end(), uint64_t(0));
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * deque.size());
+}
+BENCHMARK(BM_SumSegmented)->Apply(Sizes);
+
+// A queue that stays short, as in a work list: each push is matched by a
+// pop from the other end. RingDeque keeps it in one ring, Deque walks
+// through its blocks.
+template <typename Queue>
+static void BM_SmallQueue(benchmark::State& state) {
+  Queue queue;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    queue.push_back(i);
+  }
+  uint64_t sum = 0;
+  uint64_t next = state.range(0);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kBatch; ++i) {
+      sum += queue[0];
+      queue.pop_front();
+      queue.push_back(next++);
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK_TEMPLATE(BM_SmallQueue, Deque<uint64_t>)
+    ->RangeMultiplier(4)
+    ->Range(4, kMaxSmallQueue);
+BENCHMARK_TEMPLATE(BM_SmallQueue, RingDeque<uint64_t>)
+    ->RangeMultiplier(4)
+    ->Range(4, kMaxSmallQueue);
+
+// One producer thread hands kHandoffs elements to the benchmark thread.
+static void BM_MutexHandoff(benchmark::State& state) {
+  for (auto _ : state) {
+    Deque<uint64_t> deque;
+    std::mutex mutex;
+    std::thread producer([&] {
+      for (size_t i = 0; i < kHandoffs; ++i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        deque.push_back(i);
+      }
+    });
+    uint64_t sum = 0;
+    for (size_t popped = 0; popped < kHandoffs;) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!deque.empty()) {
+        sum += deque[0];
+        deque.pop_front();
+        ++popped;
+      }
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kHandoffs);
+}
+BENCHMARK(BM_MutexHandoff)->UseRealTime();
+
+static void BM_SpscHandoff(benchmark::State& state) {
+  for (auto _ : state) {
+    SpscDeque<uint64_t> queue;
+    std::thread producer([&] {
+      for (size_t i = 0; i < kHandoffs; ++i) {
+        queue.push(i);
+      }
+    });
+    uint64_t sum = 0;
+    uint64_t value;
+    for (size_t popped = 0; popped < kHandoffs;) {
+      if (queue.try_pop(value)) {
+        sum += value;
+        ++popped;
+      }
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kHandoffs);
+}
+BENCHMARK(BM_SpscHandoff)->UseRealTime();
+
+static void BM_SpscHandoffBatch(benchmark::State& state) {
+  for (auto _ : state) {
+    SpscDeque<uint64_t> queue;
+    std::thread producer([&] {
+      uint64_t batch[kBatch];
+      for (size_t i = 0; i < kHandoffs; i += kBatch) {
+        for (size_t j = 0; j < kBatch; ++j) {
+          batch[j] = i + j;
+        }
+        queue.push_bulk(batch, batch + kBatch);
+      }
+    });
+    uint64_t sum = 0;
+    uint64_t batch[kBatch];
+    for (size_t popped = 0; popped < kHandoffs;) {
+      size_t count = queue.pop_bulk(batch, kBatch);
+      for (size_t j = 0; j < count; ++j) {
+        sum += batch[j];
+      }
+      popped += count;
+    }
+    producer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kHandoffs);
+}
+BENCHMARK(BM_SpscHandoffBatch)->UseRealTime();
+
+// Every thread pushes and then pops one element per iteration on a queue
+// shared by all of them.
+static void BM_MutexContention(benchmark::State& state) {
+  static Deque<uint64_t> deque;
+  static std::mutex mutex;
+  uint64_t sum = 0;
+  for (auto _ : state) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      deque.push_back(state.thread_index());
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!deque.empty()) {
+      sum += deque[0];
+      deque.pop_front();
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MutexContention)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+static void BM_MpmcContention(benchmark::State& state) {
+  static MpmcDeque<uint64_t> queue;
+  uint64_t sum = 0;
+  uint64_t value;
+  for (auto _ : state) {
+    queue.try_push(state.thread_index());
+    if (queue.try_pop(value)) {
+      sum += value;
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MpmcContention)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+static void BM_MpmcBoundedContention(benchmark::State& state) {
+  static MpmcDeque<uint64_t> queue(kBoundedCapacity);
+  uint64_t sum = 0;
+  uint64_t value;
+  for (auto _ : state) {
+    queue.try_push(state.thread_index());
+    if (queue.try_pop(value)) {
+      sum += value;
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MpmcBoundedContention)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+static void BM_ParallelReduce(benchmark::State& state) {
+  std::vector<uint64_t> data(kReduceElements);
+  std::iota(data.begin(), data.end(), 0);
+  if (ParallelSum(data, state.range(0)) !=
+      kReduceElements * (kReduceElements - 1) / 2) {
+    state.SkipWithError("wrong sum");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ParallelSum(data, state.range(0)));
+  }
+  state.SetItemsProcessed(state.iterations() * kReduceElements);
+}
+BENCHMARK(BM_ParallelReduce)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -4,14 +4,43 @@
  * @date 05.01.2023
  */
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 #include <exception>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <ranges>
+#include <span>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
-template <typename T, typename Alloc = std::allocator<T>>
+const size_t kBlockBytes = 4096;
+const size_t kMinBlockSize = 16;
+const size_t kDefaultSpareBlocks = 4;
+const size_t kCacheLine = 64;
+
+// Elements per block: as many T as fit in kBlockBytes, rounded down to a
+// power of two so that index math is a shift and a mask.
+template <typename T>
+constexpr size_t DequeBlockSize() {
+  size_t count = kBlockBytes / sizeof(T);
+  return count < kMinBlockSize ? kMinBlockSize : std::bit_floor(count);
+}
+
+// Up to SpareBlocks freed blocks are kept for reuse by either end, so a
+// queue that pops from one end and pushes to the other stops allocating.
+template <typename T, typename Alloc = std::allocator<T>,
+          size_t BlockSize = DequeBlockSize<T>(),
+          size_t SpareBlocks = kDefaultSpareBlocks>
 class Deque {
+  static_assert(std::has_single_bit(BlockSize),
+                "BlockSize must be a power of two");
+
  public:
   template <bool IsConst>
   class Iterator;
@@ -70,16 +99,17 @@ class Deque {
   Deque& operator=(Deque&& other);
 
   ~Deque() {
+    release_spare();
     if (!arr_.empty()) {
       if (arr_[first_block_] == nullptr || arr_[last_block_] == nullptr) {
         return;
       }
       while (first_block_ < last_block_) {
-        while (first_element_ < kDefaultBlockSize) {
+        while (first_element_ < kBlockSize) {
           alloc_traits::destroy(alloc_, arr_[first_block_] + first_element_);
           ++first_element_;
         }
-        alloc_traits::deallocate(alloc_, arr_[first_block_], kDefaultBlockSize);
+        alloc_traits::deallocate(alloc_, arr_[first_block_], kBlockSize);
         first_element_ = 0;
         ++first_block_;
       }
@@ -88,7 +118,7 @@ class Deque {
         alloc_traits::destroy(alloc_, arr_[last_block_] + first_element_);
         ++first_element_;
       }
-      alloc_traits::deallocate(alloc_, arr_[last_block_], kDefaultBlockSize);
+      alloc_traits::deallocate(alloc_, arr_[last_block_], kBlockSize);
     }
   }
 
@@ -115,41 +145,55 @@ class Deque {
 
   Alloc get_allocator() { return alloc_; }
 
-  void insert(const iterator& iter, const T& elem) {
-    if (iter == end()) {
-      push_back(elem);
-      return;
-    }
+  void insert(const iterator& iter, const T& elem) { emplace(iter, elem); }
 
-    T temp = *(end() - 1);
-    auto iter2 = end() - 1;
-    while (iter < iter2) {
-      *iter2 = *(iter2 - 1);
-      --iter2;
-    }
-    *iter2 = T(elem);
-    push_back(temp);
+  void insert(const iterator& iter, T&& elem) {
+    emplace(iter, std::move(elem));
   }
 
-  void erase(iterator iter) {
-    auto it_end = end();
+  void erase(iterator iter) { erase(iter, iter + 1); }
 
-    while (iter <= it_end) {
-      *iter = *(iter + 1);
-      ++iter;
-    }
+  template <typename... Args>
+  iterator emplace(const iterator& iter, Args&&... args);
 
-    --arr_size_;
-    if (last_element_ == 0) {
-      last_element_ = kDefaultBlockSize - 1;
-      --last_block_;
-    } else {
-      --last_element_;
-    }
-  }
+  // Insert and erase move whichever side of the position is shorter, once,
+  // by the length of the range. Only the basic guarantee holds when T's
+  // move or the range throws.
+  template <std::forward_iterator ForwardIt>
+  iterator insert(const iterator& iter, ForwardIt first, ForwardIt last);
+
+  // Single-pass ranges are read into a buffer first, since the count has to
+  // be known before anything is shifted.
+  template <std::input_iterator InputIt>
+  iterator insert(const iterator& iter, InputIt first, InputIt last);
+
+  iterator erase(const iterator& first, const iterator& last);
+
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last);
+
+  // Fill whole blocks at once; for forward ranges either every element is
+  // added or the deque is left unchanged.
+  template <typename Range>
+  void append_range(Range&& range);
+
+  template <typename Range>
+  void prepend_range(Range&& range);
+
+  // Calls f with a std::span per block, front to back, so that per-element
+  // loops run over plain pointers instead of Iterator::operator++.
+  template <typename F>
+  void for_each_segment(F f);
+
+  template <typename F>
+  void for_each_segment(F f) const;
 
  private:
-  std::vector<T*> arr_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+  using map_alloc = typename alloc_traits::template rebind_alloc<T*>;
+
+  // Block pointers, allocated through Alloc like the blocks themselves.
+  std::vector<T*, map_alloc> arr_;
   size_t arr_size_;
   size_t map_size_;
 
@@ -159,18 +203,83 @@ class Deque {
   size_t last_element_;
   size_t last_block_;
   Alloc alloc_;
-  using alloc_traits = std::allocator_traits<Alloc>;
 
-  static const size_t kDefaultArrSize = 8;
-  static const size_t kDefaultBlockSize = 1000;
+  static constexpr size_t kDefaultArrSize = 8;
+  static constexpr size_t kBlockSize = BlockSize;
+  static constexpr size_t kBlockShift = std::countr_zero(BlockSize);
+  static constexpr size_t kBlockMask = BlockSize - 1;
+
+  std::array<T*, SpareBlocks> spare_;
+  size_t spare_count_ = 0;
+
+  static constexpr bool kTrivial = std::is_trivially_copyable_v<T>;
+
+  // Makes sure the map has `blocks` free slots before the first block or
+  // after the last one. Recenters the used range in place while the map is
+  // at most half full, otherwise moves it into a map twice the size.
+  void reserve_map(bool at_front, size_t blocks = 1);
+
+  // Positions below are offsets from the start of the map: block number
+  // times kBlockSize plus the slot in the block.
+  size_t first_pos() const {
+    return (first_block_ << kBlockShift) + first_element_;
+  }
+
+  T* slot(size_t pos) const {
+    return arr_[pos >> kBlockShift] + (pos & kBlockMask);
+  }
+
+  iterator iter_at(size_t pos) {
+    return iterator(&arr_[pos >> kBlockShift], pos & kBlockMask);
+  }
 
-  void expand_arr();
-  void expand_arr1();
+  // Allocate the blocks for count more elements at one end without
+  // changing the size and return the last (first) reserved block, so that
+  // release_back (release_front) can give back whatever was not used.
+  size_t reserve_back(size_t count);
+  size_t reserve_front(size_t count);
+  void release_back(size_t reserved);
+  void release_front(size_t reserved);
+
+  void grow_back(size_t count);
+  void grow_front(size_t count);
+  void shrink_back(size_t count);
+  void shrink_front(size_t count);
+
+  // Inserts count elements starting at first; each is read exactly once,
+  // so first may be a std::move_iterator.
+  template <typename ForwardIt>
+  iterator insert_n(size_t idx, ForwardIt first, size_t count);
+  template <typename ForwardIt>
+  void insert_shifting_tail(size_t idx, ForwardIt first, size_t count);
+  template <typename ForwardIt>
+  void insert_shifting_head(size_t idx, ForwardIt first, size_t count);
+
+  // Constructs count elements from src at pos, a block at a time. On an
+  // exception the elements built so far are destroyed.
+  template <typename It>
+  void construct_span(size_t pos, It& src, size_t count);
+  void destroy_span(size_t pos, size_t count);
+
+  // Move count elements from `from` to `to` by assignment; memmove whole
+  // runs within blocks when T is trivially copyable.
+  void move_down(size_t from, size_t to, size_t count);
+  void move_up(size_t from, size_t to, size_t count);
+
+  T* allocate_block();
+  void deallocate_block(T* block);
+  void release_spare();
+
+  // Offset from the start of the first block, split by shift and mask.
+  T* element(size_t num) const {
+    size_t index = first_element_ + num;
+    return arr_[first_block_ + (index >> kBlockShift)] + (index & kBlockMask);
+  }
 };
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
 template <bool IsConst>
-class Deque<T, Alloc>::Iterator {
+class Deque<T, Alloc, BlockSize, SpareBlocks>::Iterator {
  public:
   using is_const = std::conditional_t<IsConst, const T, T>;
   using value_type = T;
@@ -179,6 +288,8 @@ class Deque<T, Alloc>::Iterator {
   using iterator_category = std::random_access_iterator_tag;
   using difference_type = int;
 
+  Iterator() = default;
+
   Iterator(T** ptr, const size_t& index) : ptr_(ptr), num_(index) {}
 
   reference operator*() const { return *(*ptr_ + num_); }
@@ -188,7 +299,7 @@ class Deque<T, Alloc>::Iterator {
   value_type operator->() const { return *(*ptr_ + num_); }
 
   Iterator& operator++() {
-    if (num_ < kDefaultBlockSize - 1) {
+    if (num_ < kBlockSize - 1) {
       ++num_;
     } else {
       ++ptr_;
@@ -208,7 +319,7 @@ class Deque<T, Alloc>::Iterator {
       --num_;
     } else {
       --ptr_;
-      num_ = kDefaultBlockSize - 1;
+      num_ = kBlockSize - 1;
     }
     return *this;
   }
@@ -219,24 +330,15 @@ class Deque<T, Alloc>::Iterator {
     return copy;
   }
 
+  // Signed shift floors, so offsets before the current block work too.
   Iterator& operator+=(int value) {
-    num_ += value;
-    ptr_ += num_ / kDefaultBlockSize;
-    num_ = num_ % kDefaultBlockSize;
+    std::ptrdiff_t index = static_cast<std::ptrdiff_t>(num_) + value;
+    ptr_ += index >> kBlockShift;
+    num_ = index & kBlockMask;
     return *this;
   }
 
-  Iterator& operator-=(int value) {
-    if (static_cast<size_t>(value) >= num_ + 1) {
-      value -= num_ + 1;
-      ptr_ -= value / kDefaultBlockSize + 1;
-      num_ = kDefaultBlockSize - 1 - (value % kDefaultBlockSize);
-
-      return *this;
-    }
-    num_ -= value;
-    return *this;
-  }
+  Iterator& operator-=(int value) { return *this += -value; }
 
   friend Iterator operator+(int value, const Iterator& iter) {
     Iterator copy(iter);
@@ -278,17 +380,103 @@ class Deque<T, Alloc>::Iterator {
     return !(first < second);
   }
 
-  difference_type operator-(const Iterator& other) {
-    return (ptr_ - other.ptr_) * kDefaultBlockSize + (num_ - other.num_);
+  difference_type operator-(const Iterator& other) const {
+    return (ptr_ - other.ptr_) * kBlockSize + (num_ - other.num_);
+  }
+
+  // Block-aware versions of the std algorithms, found by ADL when called
+  // unqualified. Each runs the std algorithm on one contiguous span at a
+  // time.
+  template <typename F>
+  friend void for_each_segment(Iterator first, Iterator last, F f) {
+    walk(first, last, [&f](pointer begin, pointer end) {
+      f(std::span<is_const>(begin, end));
+      return true;
+    });
+  }
+
+  template <typename OutputIt>
+  friend OutputIt copy(Iterator first, Iterator last, OutputIt out) {
+    walk(first, last, [&out](pointer begin, pointer end) {
+      out = std::copy(begin, end, out);
+      return true;
+    });
+    return out;
+  }
+
+  friend void fill(Iterator first, Iterator last, const T& value)
+    requires(!IsConst)
+  {
+    walk(first, last, [&value](pointer begin, pointer end) {
+      std::fill(begin, end, value);
+      return true;
+    });
+  }
+
+  template <typename U>
+  friend Iterator find(Iterator first, Iterator last, const U& value) {
+    Iterator res = last;
+    walk(first, last, [&](pointer begin, pointer end) {
+      pointer found = std::find(begin, end, value);
+      if (found == end) {
+        first += end - begin;
+        return true;
+      }
+      res = first + static_cast<int>(found - begin);
+      return false;
+    });
+    return res;
+  }
+
+  template <typename U>
+  friend U accumulate(Iterator first, Iterator last, U init) {
+    walk(first, last, [&init](pointer begin, pointer end) {
+      init = std::accumulate(begin, end, std::move(init));
+      return true;
+    });
+    return init;
   }
 
  private:
-  T** ptr_;
-  size_t num_;
+  T** ptr_ = nullptr;
+  size_t num_ = 0;
+
+  // Calls f(begin, end) for each block's share of [first, last) until it
+  // returns false.
+  template <typename F>
+  static void walk(Iterator first, Iterator last, F f) {
+    for (; first.ptr_ < last.ptr_; ++first.ptr_, first.num_ = 0) {
+      if (!f(*first.ptr_ + first.num_, *first.ptr_ + kBlockSize)) {
+        return;
+      }
+    }
+    if (first.num_ < last.num_) {
+      f(*first.ptr_ + first.num_, *first.ptr_ + last.num_);
+    }
+  }
 };
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque() {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename F>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::for_each_segment(F f) {
+  for (size_t block = first_block_; block <= last_block_; ++block) {
+    size_t begin = block == first_block_ ? first_element_ : 0;
+    size_t end = block == last_block_ ? last_element_ : kBlockSize;
+    if (begin < end) {
+      f(std::span<T>(arr_[block] + begin, end - begin));
+    }
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename F>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::for_each_segment(F f) const {
+  const_cast<Deque*>(this)->for_each_segment(
+      [&f](std::span<T> span) { f(std::span<const T>(span)); });
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque() {
   arr_.resize(kDefaultArrSize);
   map_size_ = kDefaultArrSize;
 
@@ -300,11 +488,12 @@ Deque<T, Alloc>::Deque() {
 
   arr_size_ = 0;
 
-  arr_[first_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+  arr_[first_block_] = allocate_block();
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque(const Alloc& alloc) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque(const Alloc& alloc)
+    : arr_(alloc), alloc_(alloc) {
   arr_.resize(kDefaultArrSize);
   map_size_ = kDefaultArrSize;
 
@@ -316,16 +505,17 @@ Deque<T, Alloc>::Deque(const Alloc& alloc) {
 
   arr_size_ = 0;
 
-  arr_[first_block_] = alloc_traits::allocate(alloc, kDefaultBlockSize);
+  arr_[first_block_] = allocate_block();
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>& Deque<T, Alloc>::operator=(const Deque& other) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>&
+Deque<T, Alloc, BlockSize, SpareBlocks>::operator=(const Deque& other) {
   if (alloc_traits::propagate_on_container_copy_assignment::value &&
       alloc_ != other.alloc_) {
     alloc_ = other.alloc_;
   }
-  Deque<T, Alloc> tmp(other);
+  Deque tmp(other);
   std::swap(arr_, tmp.arr_);
   std::swap(arr_size_, tmp.arr_size_);
   std::swap(map_size_, tmp.map_size_);
@@ -338,32 +528,34 @@ Deque<T, Alloc>& Deque<T, Alloc>::operator=(const Deque& other) {
   return *this;
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>& Deque<T, Alloc>::operator=(Deque&& other) {
-  if (*this != other) {
-    alloc_ = std::move(other.alloc_);
-    arr_size_ = other.arr_size_;
-    map_size_ = other.map_size_;
-
-    first_element_ = other.first_element_;
-    first_block_ = other.first_block_;
-
-    last_element_ = other.last_element_;
-    last_block_ = other.last_block_;
-    arr_.resize(arr_size_);
-
-    for (size_t i = first_block_; i <= last_block_; ++i) {
-      arr_[i] = other.arr_[i];
-      other.arr_[i] = nullptr;
-    }
-    other.arr_.clear();
-    other.arr_size_ = 0;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>&
+Deque<T, Alloc, BlockSize, SpareBlocks>::operator=(Deque&& other) {
+  if (this != &other) {
+    // tmp takes over the old elements and spare blocks, and frees them with
+    // the allocator that made them.
+    Deque tmp(std::move(other));
+    // Moves rather than std::swap, which needs equal map allocators unless
+    // they propagate on swap.
+    tmp.arr_ = std::exchange(arr_, std::move(tmp.arr_));
+    std::swap(arr_size_, tmp.arr_size_);
+    std::swap(map_size_, tmp.map_size_);
+
+    std::swap(first_element_, tmp.first_element_);
+    std::swap(first_block_, tmp.first_block_);
+
+    std::swap(last_element_, tmp.last_element_);
+    std::swap(last_block_, tmp.last_block_);
+
+    std::swap(alloc_, tmp.alloc_);
+    std::swap(spare_, tmp.spare_);
+    std::swap(spare_count_, tmp.spare_count_);
   }
   return *this;
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque(const Deque& other) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque(const Deque& other) {
   arr_size_ = other.arr_size_;
   map_size_ = other.map_size_;
 
@@ -376,10 +568,10 @@ Deque<T, Alloc>::Deque(const Deque& other) {
 
   arr_.resize(map_size_);
   for (size_t i = first_block_; i < last_block_; ++i) {
-    arr_[i] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+    arr_[i] = allocate_block();
     size_t arrays_to_del = 0;
     try {
-      for (; arrays_to_del < kDefaultBlockSize; arrays_to_del++) {
+      for (; arrays_to_del < kBlockSize; arrays_to_del++) {
         alloc_traits::construct(alloc_, arr_[i] + arrays_to_del,
                                 other.arr_[i][arrays_to_del]);
       }
@@ -387,11 +579,11 @@ Deque<T, Alloc>::Deque(const Deque& other) {
       for (size_t j = 0; j < arrays_to_del; ++j) {
         alloc_traits::destroy(alloc_, arr_[i] + j);
       }
-      alloc_traits::deallocate(alloc_, arr_[i], kDefaultBlockSize);
+      alloc_traits::deallocate(alloc_, arr_[i], kBlockSize);
       throw;
     }
   }
-  arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+  arr_[last_block_] = allocate_block();
   size_t arrays_to_del = 0;
   try {
     for (; arrays_to_del < last_element_; ++arrays_to_del) {
@@ -402,17 +594,17 @@ Deque<T, Alloc>::Deque(const Deque& other) {
     for (size_t j = 0; j < arrays_to_del; ++j) {
       alloc_traits::destroy(alloc_, arr_[last_block_] + j);
     }
-    alloc_traits::deallocate(alloc_, arr_[last_block_], kDefaultBlockSize);
+    alloc_traits::deallocate(alloc_, arr_[last_block_], kBlockSize);
     throw;
   }
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque(size_t count, const Alloc& alloc)
-    : arr_size_(count), alloc_(alloc) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque(size_t count, const Alloc& alloc)
+    : arr_(alloc), arr_size_(count), alloc_(alloc) {
   size_t amount_of_arr;
-  size_t rest_blocks = count % kDefaultBlockSize;
-  amount_of_arr = count / kDefaultBlockSize + 1;
+  size_t rest_blocks = count & kBlockMask;
+  amount_of_arr = (count >> kBlockShift) + 1;
 
   arr_.resize(amount_of_arr * 4);
   map_size_ = amount_of_arr * 4;
@@ -423,21 +615,21 @@ Deque<T, Alloc>::Deque(size_t count, const Alloc& alloc)
   last_block_ = first_block_ + amount_of_arr - 1;
 
   for (size_t i = first_block_; i < last_block_; ++i) {
-    arr_[i] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+    arr_[i] = allocate_block();
     size_t arrays_to_del = 0;
     try {
-      for (; arrays_to_del < kDefaultBlockSize; ++arrays_to_del) {
+      for (; arrays_to_del < kBlockSize; ++arrays_to_del) {
         alloc_traits::construct(alloc_, arr_[i] + arrays_to_del);
       }
     } catch (...) {
       for (size_t j = 0; j < arrays_to_del; ++j) {
         alloc_traits::destroy(alloc_, arr_[arrays_to_del] + j);
       }
-      alloc_traits::deallocate(alloc_, arr_[i], kDefaultBlockSize);
+      alloc_traits::deallocate(alloc_, arr_[i], kBlockSize);
       throw;
     }
   }
-  arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+  arr_[last_block_] = allocate_block();
   size_t arrays_to_del = 0;
   try {
     for (; arrays_to_del < rest_blocks; ++arrays_to_del) {
@@ -447,15 +639,16 @@ Deque<T, Alloc>::Deque(size_t count, const Alloc& alloc)
     for (size_t j = 0; j < arrays_to_del; ++j) {
       alloc_traits::destroy(alloc_, arr_[last_block_] + j);
     }
-    alloc_traits::deallocate(alloc_, arr_[last_block_], kDefaultBlockSize);
+    alloc_traits::deallocate(alloc_, arr_[last_block_], kBlockSize);
     throw;
   }
 
   last_element_ = rest_blocks;
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque(Deque&& other) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque(Deque&& other)
+    : arr_(std::move(other.arr_)) {
   arr_size_ = other.arr_size_;
   map_size_ = other.map_size_;
 
@@ -465,7 +658,8 @@ Deque<T, Alloc>::Deque(Deque&& other) {
   last_element_ = other.last_element_;
   last_block_ = other.last_block_;
   alloc_ = std::move(other.alloc_);
-  arr_ = std::move(other.arr_);
+  spare_ = other.spare_;
+  spare_count_ = std::exchange(other.spare_count_, 0);
   other.arr_.clear();
   other.arr_size_ = 0;
   other.first_block_ = kDefaultArrSize / 2;
@@ -474,9 +668,10 @@ Deque<T, Alloc>::Deque(Deque&& other) {
   other.last_element_ = 0;
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque(std::initializer_list<T> init, const Alloc& alloc)
-    : alloc_(alloc) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque(std::initializer_list<T> init,
+                                               const Alloc& alloc)
+    : arr_(alloc), alloc_(alloc) {
   arr_.resize(kDefaultArrSize);
   map_size_ = kDefaultArrSize;
 
@@ -487,18 +682,17 @@ Deque<T, Alloc>::Deque(std::initializer_list<T> init, const Alloc& alloc)
   last_element_ = first_element_;
 
   arr_size_ = 0;
-  arr_[first_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
-  for (const auto& elem : init) {
-    push_back(elem);
-  }
+  arr_[first_block_] = allocate_block();
+  append_range(init);
 }
 
-template <typename T, typename Alloc>
-Deque<T, Alloc>::Deque(size_t count, const T& value, const Alloc& alloc)
-    : arr_size_(count), alloc_(alloc) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+Deque<T, Alloc, BlockSize, SpareBlocks>::Deque(size_t count, const T& value,
+                                               const Alloc& alloc)
+    : arr_(alloc), arr_size_(count), alloc_(alloc) {
   size_t amount_of_arr;
-  size_t rest_blocks = count % kDefaultBlockSize;
-  amount_of_arr = count / kDefaultBlockSize + 1;
+  size_t rest_blocks = count & kBlockMask;
+  amount_of_arr = (count >> kBlockShift) + 1;
 
   arr_.resize(amount_of_arr * 4);
   map_size_ = amount_of_arr * 4;
@@ -509,22 +703,22 @@ Deque<T, Alloc>::Deque(size_t count, const T& value, const Alloc& alloc)
   last_block_ = first_block_ + amount_of_arr - 1;
 
   for (size_t i = first_block_; i < last_block_; ++i) {
-    arr_[i] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+    arr_[i] = allocate_block();
     size_t arrays_to_del = 0;
     try {
-      for (; arrays_to_del < kDefaultBlockSize; ++arrays_to_del) {
+      for (; arrays_to_del < kBlockSize; ++arrays_to_del) {
         alloc_traits::construct(alloc_, arr_[i] + arrays_to_del, value);
       }
     } catch (...) {
       for (size_t j = 0; j < arrays_to_del; ++j) {
         alloc_traits::destroy(alloc_, arr_[arrays_to_del] + j);
       }
-      alloc_traits::deallocate(alloc_, arr_[i], kDefaultBlockSize);
+      alloc_traits::deallocate(alloc_, arr_[i], kBlockSize);
       throw;
     }
   }
 
-  arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+  arr_[last_block_] = allocate_block();
   size_t arrays_to_del = 0;
   try {
     for (; arrays_to_del < rest_blocks; ++arrays_to_del) {
@@ -534,161 +728,115 @@ Deque<T, Alloc>::Deque(size_t count, const T& value, const Alloc& alloc)
     for (size_t j = 0; j < arrays_to_del; ++j) {
       alloc_traits::destroy(alloc_, arr_[last_block_] + j);
     }
-    alloc_traits::deallocate(alloc_, arr_[last_block_], kDefaultBlockSize);
+    alloc_traits::deallocate(alloc_, arr_[last_block_], kBlockSize);
     throw;
   }
 
   last_element_ = rest_blocks;
 }
 
-template <typename T, typename Alloc>
-T& Deque<T, Alloc>::operator[](size_t num) {
-  size_t block_num = first_block_;
-  size_t element_num;
-  if (num < kDefaultBlockSize - first_element_) {
-    element_num = num + first_element_;
-  } else {
-    num -= kDefaultBlockSize - first_element_;
-    ++block_num;
-    size_t rest = num / kDefaultBlockSize;
-    block_num += rest;
-    element_num = num - rest * kDefaultBlockSize;
-  }
-  return arr_[block_num][element_num];
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+T& Deque<T, Alloc, BlockSize, SpareBlocks>::operator[](size_t num) {
+  return *element(num);
 }
 
-template <typename T, typename Alloc>
-const T& Deque<T, Alloc>::operator[](size_t num) const {
-  size_t block_num = first_block_;
-  size_t element_num;
-  if (num < kDefaultBlockSize - first_element_) {
-    element_num = num + first_element_;
-  } else {
-    num -= kDefaultBlockSize - first_element_;
-    ++block_num;
-    size_t rest = num / kDefaultBlockSize;
-    block_num += rest;
-    element_num = num - rest * kDefaultBlockSize;
-  }
-  return arr_[block_num][element_num];
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+const T& Deque<T, Alloc, BlockSize, SpareBlocks>::operator[](size_t num) const {
+  return *element(num);
 }
 
-template <typename T, typename Alloc>
-T& Deque<T, Alloc>::at(size_t num) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+T& Deque<T, Alloc, BlockSize, SpareBlocks>::at(size_t num) {
   if (num >= arr_size_) {
     throw std::out_of_range("out of deque");
   }
-  size_t block_num = first_block_;
-  size_t element_num;
-  if (num < kDefaultBlockSize - first_element_) {
-    element_num = num + first_element_;
-  } else {
-    num -= kDefaultBlockSize - first_element_;
-    ++block_num;
-    size_t rest = num / kDefaultBlockSize;
-    block_num += rest;
-    element_num = num - rest * kDefaultBlockSize;
-  }
-  return arr_[block_num][element_num];
+  return *element(num);
 }
 
-template <typename T, typename Alloc>
-const T& Deque<T, Alloc>::at(size_t num) const {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+const T& Deque<T, Alloc, BlockSize, SpareBlocks>::at(size_t num) const {
   if (num >= arr_size_) {
     throw std::out_of_range("out of deque");
   }
-  size_t block_num = first_block_;
-  size_t element_num;
-  if (num < kDefaultBlockSize - first_element_) {
-    element_num = num + first_element_;
-  } else {
-    num -= kDefaultBlockSize - first_element_;
-    ++block_num;
-    size_t rest = num / kDefaultBlockSize;
-    block_num += rest;
-    element_num = num - rest * kDefaultBlockSize;
-  }
-  return arr_[block_num][element_num];
-}
-
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::expand_arr() {
-  std::vector<T*> new_arr(3 * map_size_);
-  std::copy(arr_.begin(), arr_.end(), new_arr.begin() + map_size_ / 2);
-  first_block_ += map_size_ / 2;
-  last_block_ += map_size_ / 2 + 1;
-  map_size_ *= 3;
-  arr_.clear();
-  arr_ = new_arr;
-  arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
-}
-
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::expand_arr1() {
-  std::vector<T*> new_arr(2 * map_size_);
-  std::copy(arr_.begin(), arr_.end(), new_arr.begin() + map_size_ / 2);
-  first_block_ += map_size_ / 2 - 1;
-  last_block_ += map_size_ / 2;
-  map_size_ *= 2;
-
-  arr_.clear();
-  arr_ = new_arr;
-  arr_[first_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
-}
-
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::push_back(const T& value) {
-  try {
-    alloc_traits::construct(alloc_, arr_[last_block_] + last_element_, value);
-  } catch (...) {
-    alloc_traits::destroy(alloc_, arr_[last_block_] + last_element_);
-    throw;
+  return *element(num);
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::reserve_map(bool at_front,
+                                                          size_t blocks) {
+  if (at_front ? first_block_ >= blocks
+               : last_block_ + blocks < map_size_) {
+    return;
   }
-  ++last_element_;
-  ++arr_size_;
-  if (last_element_ == kDefaultBlockSize) {
-    if (last_block_ != map_size_ - 1) {
-      last_element_ = 0;
-      ++last_block_;
-      arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+  size_t used = last_block_ - first_block_ + 1;
+  size_t needed = used + blocks;
+  size_t shift = at_front ? blocks : 0;
+  auto first = arr_.begin() + first_block_;
+  auto last = arr_.begin() + last_block_ + 1;
+  size_t new_first;
+  if (2 * needed <= map_size_) {
+    new_first = (map_size_ - needed) / 2 + shift;
+    if (new_first < first_block_) {
+      std::copy(first, last, arr_.begin() + new_first);
+      std::fill(arr_.begin() + new_first + used, last, nullptr);
     } else {
-      expand_arr();
-      last_element_ = 0;
+      std::copy_backward(first, last, arr_.begin() + new_first + used);
+      std::fill(first, arr_.begin() + new_first, nullptr);
     }
+  } else {
+    std::vector<T*, map_alloc> new_arr(2 * std::max(map_size_, needed),
+                                       arr_.get_allocator());
+    new_first = (new_arr.size() - needed) / 2 + shift;
+    std::copy(first, last, new_arr.begin() + new_first);
+    arr_ = std::move(new_arr);
+    map_size_ = arr_.size();
   }
+  first_block_ = new_first;
+  last_block_ = new_first + used - 1;
 }
 
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::push_back(T&& value) {
-  try {
-    alloc_traits::construct(alloc_, arr_[last_block_] + last_element_,
-                            std::move(value));
-  } catch (...) {
-    alloc_traits::destroy(alloc_, arr_[last_block_] + last_element_);
-    throw;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+T* Deque<T, Alloc, BlockSize, SpareBlocks>::allocate_block() {
+  if (spare_count_ > 0) {
+    return spare_[--spare_count_];
   }
-  ++last_element_;
-  ++arr_size_;
-  if (last_element_ == kDefaultBlockSize) {
-    if (last_block_ != map_size_ - 1) {
-      last_element_ = 0;
-      ++last_block_;
-      arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
-    } else {
-      expand_arr();
-      last_element_ = 0;
-    }
+  return alloc_traits::allocate(alloc_, kBlockSize);
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::deallocate_block(T* block) {
+  if (spare_count_ < SpareBlocks) {
+    spare_[spare_count_++] = block;
+    return;
+  }
+  alloc_traits::deallocate(alloc_, block, kBlockSize);
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::release_spare() {
+  while (spare_count_ > 0) {
+    alloc_traits::deallocate(alloc_, spare_[--spare_count_], kBlockSize);
   }
 }
 
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::pop_back() {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::push_back(const T& value) {
+  emplace_back(value);
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::pop_back() {
   --arr_size_;
   if (last_element_ == 0) {
     alloc_traits::destroy(alloc_,
-                          arr_[last_block_ - 1] + kDefaultBlockSize - 1);
-    last_element_ = kDefaultBlockSize - 1;
-    alloc_traits::deallocate(alloc_, arr_[last_block_], kDefaultBlockSize);
+                          arr_[last_block_ - 1] + kBlockSize - 1);
+    last_element_ = kBlockSize - 1;
+    deallocate_block(arr_[last_block_]);
     --last_block_;
   } else {
     alloc_traits::destroy(alloc_, arr_[last_block_] + last_element_ - 1);
@@ -696,136 +844,429 @@ void Deque<T, Alloc>::pop_back() {
   }
 }
 
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::push_front(const T& value) {
-  size_t copy_first_block = first_block_;
-  size_t copy_first_elem = first_element_;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::push_front(const T& value) {
+  emplace_front(value);
+}
 
-  if (first_element_ == 0) {
-    if (first_block_ == 0) {
-      expand_arr1();
-      first_element_ = kDefaultBlockSize;
-    } else {
-      first_element_ = kDefaultBlockSize;
-      --first_block_;
-      arr_[first_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::push_front(T&& value) {
+  emplace_front(std::move(value));
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::pop_front() {
+  --arr_size_;
+  ++first_element_;
+
+  if (first_element_ == kBlockSize) {
+    alloc_traits::destroy(alloc_, arr_[first_block_] + kBlockSize - 1);
+    deallocate_block(arr_[first_block_]);
+    ++first_block_;
+    first_element_ = 0;
+  } else {
+    alloc_traits::destroy(alloc_, arr_[first_block_] + first_element_ - 1);
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename... Args>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::emplace_back(Args&&... args) {
+  alloc_traits::construct(alloc_, arr_[last_block_] + last_element_,
+                          std::forward<Args>(args)...);
+  ++last_element_;
+  ++arr_size_;
+  if (last_element_ == kBlockSize) {
+    try {
+      reserve_map(false);
+      arr_[last_block_ + 1] = allocate_block();
+    } catch (...) {
+      --last_element_;
+      --arr_size_;
+      alloc_traits::destroy(alloc_, arr_[last_block_] + last_element_);
+      throw;
     }
+    last_element_ = 0;
+    ++last_block_;
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename... Args>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::emplace_front(Args&&... args) {
+  bool new_block = first_element_ == 0;
+  if (new_block) {
+    reserve_map(true);
+    T* block = allocate_block();
+    arr_[first_block_ - 1] = block;
+    --first_block_;
+    first_element_ = kBlockSize;
   }
   try {
     alloc_traits::construct(alloc_, arr_[first_block_] + first_element_ - 1,
-                            value);
+                            std::forward<Args>(args)...);
   } catch (...) {
-    alloc_traits::destroy(alloc_, arr_[first_block_] + first_element_ - 1);
-    first_block_ = copy_first_block;
-    first_element_ = copy_first_elem;
+    if (new_block) {
+      deallocate_block(arr_[first_block_]);
+      ++first_block_;
+      first_element_ = 0;
+    }
     throw;
   }
   ++arr_size_;
   --first_element_;
 }
 
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::push_front(T&& value) {
-  size_t copy_first_block = first_block_;
-  size_t copy_first_elem = first_element_;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename... Args>
+typename Deque<T, Alloc, BlockSize, SpareBlocks>::iterator
+Deque<T, Alloc, BlockSize, SpareBlocks>::emplace(const iterator& iter,
+                                                 Args&&... args) {
+  T value(std::forward<Args>(args)...);
+  return insert_n(iter - begin(), std::make_move_iterator(&value), 1);
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <std::forward_iterator ForwardIt>
+typename Deque<T, Alloc, BlockSize, SpareBlocks>::iterator
+Deque<T, Alloc, BlockSize, SpareBlocks>::insert(const iterator& iter,
+                                                ForwardIt first,
+                                                ForwardIt last) {
+  return insert_n(iter - begin(), first, std::distance(first, last));
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <std::input_iterator InputIt>
+typename Deque<T, Alloc, BlockSize, SpareBlocks>::iterator
+Deque<T, Alloc, BlockSize, SpareBlocks>::insert(const iterator& iter,
+                                                InputIt first, InputIt last) {
+  std::vector<T, Alloc> buffer(first, last, alloc_);
+  return insert_n(iter - begin(), std::make_move_iterator(buffer.begin()),
+                  buffer.size());
+}
 
-  if (first_element_ == 0) {
-    if (first_block_ == 0) {
-      expand_arr1();
-      first_element_ = kDefaultBlockSize;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename ForwardIt>
+typename Deque<T, Alloc, BlockSize, SpareBlocks>::iterator
+Deque<T, Alloc, BlockSize, SpareBlocks>::insert_n(size_t idx, ForwardIt first,
+                                                  size_t count) {
+  if (count > 0) {
+    if (idx < arr_size_ - idx) {
+      insert_shifting_head(idx, first, count);
     } else {
-      first_element_ = kDefaultBlockSize;
-      --first_block_;
-      arr_[first_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
+      insert_shifting_tail(idx, first, count);
     }
   }
+  return begin() + idx;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename ForwardIt>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::insert_shifting_tail(size_t idx,
+                                                               ForwardIt first,
+                                                               size_t count) {
+  size_t reserved = reserve_back(count);
   try {
-    alloc_traits::construct(alloc_, arr_[first_block_] + first_element_ - 1,
-                            std::move(value));
+    size_t pos = first_pos() + idx;
+    size_t end = first_pos() + arr_size_;
+    size_t tail = arr_size_ - idx;
+    if constexpr (kTrivial) {
+      move_up(pos, pos + count, tail);
+      construct_span(pos, first, count);
+      grow_back(count);
+    } else if (count >= tail) {
+      ForwardIt mid = std::next(first, tail);
+      construct_span(end, mid, count - tail);
+      grow_back(count - tail);
+      auto moved = std::make_move_iterator(iter_at(pos));
+      construct_span(pos + count, moved, tail);
+      grow_back(tail);
+      std::copy_n(first, tail, iter_at(pos));
+    } else {
+      auto moved = std::make_move_iterator(iter_at(end - count));
+      construct_span(end, moved, count);
+      grow_back(count);
+      move_up(pos, pos + count, tail - count);
+      std::copy_n(first, count, iter_at(pos));
+    }
   } catch (...) {
-    alloc_traits::destroy(alloc_, arr_[first_block_] + first_element_ - 1);
-    first_block_ = copy_first_block;
-    first_element_ = copy_first_elem;
+    release_back(reserved);
     throw;
   }
-  ++arr_size_;
-  --first_element_;
 }
 
-template <typename T, typename Alloc>
-void Deque<T, Alloc>::pop_front() {
-  --arr_size_;
-  ++first_element_;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename ForwardIt>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::insert_shifting_head(size_t idx,
+                                                               ForwardIt first,
+                                                               size_t count) {
+  size_t reserved = reserve_front(count);
+  try {
+    size_t start = first_pos();
+    size_t new_start = start - count;
+    if constexpr (kTrivial) {
+      move_down(start, new_start, idx);
+      construct_span(new_start + idx, first, count);
+      grow_front(count);
+    } else if (count >= idx) {
+      ForwardIt src = first;
+      construct_span(new_start + idx, src, count - idx);
+      grow_front(count - idx);
+      auto moved = std::make_move_iterator(iter_at(start));
+      construct_span(new_start, moved, idx);
+      grow_front(idx);
+      std::copy_n(src, idx, iter_at(start));
+    } else {
+      auto moved = std::make_move_iterator(iter_at(start));
+      construct_span(new_start, moved, count);
+      grow_front(count);
+      move_down(start + count, start, idx - count);
+      std::copy_n(first, count, iter_at(new_start + idx));
+    }
+  } catch (...) {
+    release_front(reserved);
+    throw;
+  }
+}
 
-  if (first_element_ == kDefaultBlockSize) {
-    alloc_traits::destroy(alloc_, arr_[first_block_] + kDefaultBlockSize - 1);
-    alloc_traits::deallocate(alloc_, arr_[first_block_], kDefaultBlockSize);
-    ++first_block_;
-    first_element_ = 0;
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+typename Deque<T, Alloc, BlockSize, SpareBlocks>::iterator
+Deque<T, Alloc, BlockSize, SpareBlocks>::erase(const iterator& first,
+                                               const iterator& last) {
+  size_t idx = first - begin();
+  size_t count = last - first;
+  if (count > 0) {
+    size_t pos = first_pos() + idx;
+    size_t tail = arr_size_ - idx - count;
+    if (idx < tail) {
+      move_up(first_pos(), first_pos() + count, idx);
+      shrink_front(count);
+    } else {
+      move_down(pos + count, pos, tail);
+      shrink_back(count);
+    }
+  }
+  return begin() + idx;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename InputIt>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::assign(InputIt first,
+                                                     InputIt last) {
+  erase(begin(), end());
+  append_range(std::ranges::subrange(first, last));
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename Range>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::append_range(Range&& range) {
+  if constexpr (std::ranges::forward_range<Range>) {
+    size_t count = std::ranges::distance(range);
+    size_t reserved = reserve_back(count);
+    auto src = std::ranges::begin(range);
+    try {
+      construct_span(first_pos() + arr_size_, src, count);
+    } catch (...) {
+      release_back(reserved);
+      throw;
+    }
+    grow_back(count);
   } else {
-    alloc_traits::destroy(alloc_, arr_[first_block_] + first_element_ - 1);
+    for (auto&& elem : range) {
+      emplace_back(std::forward<decltype(elem)>(elem));
+    }
   }
 }
 
-template <typename T, typename Alloc>
-template <typename... Args>
-void Deque<T, Alloc>::emplace_back(Args&&... args) {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename Range>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::prepend_range(Range&& range) {
+  if constexpr (std::ranges::forward_range<Range>) {
+    size_t count = std::ranges::distance(range);
+    size_t reserved = reserve_front(count);
+    size_t pos = first_pos() - count;
+    auto src = std::ranges::begin(range);
+    try {
+      construct_span(pos, src, count);
+    } catch (...) {
+      release_front(reserved);
+      throw;
+    }
+    grow_front(count);
+  } else {
+    size_t count = 0;
+    for (auto&& elem : range) {
+      emplace_front(std::forward<decltype(elem)>(elem));
+      ++count;
+    }
+    std::reverse(begin(), begin() + count);
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+size_t Deque<T, Alloc, BlockSize, SpareBlocks>::reserve_back(size_t count) {
+  size_t blocks = (last_element_ + count) >> kBlockShift;
+  if (blocks > 0) {
+    reserve_map(false, blocks);
+  }
+  size_t done = 0;
   try {
-    alloc_traits::construct(alloc_, arr_[last_block_] + last_element_,
-                            std::forward<Args>(args)...);
+    for (; done < blocks; ++done) {
+      arr_[last_block_ + 1 + done] = allocate_block();
+    }
   } catch (...) {
-    alloc_traits::destroy(alloc_, arr_[last_block_] + last_element_);
+    release_back(last_block_ + done);
     throw;
   }
-  ++last_element_;
-  ++arr_size_;
-  if (last_element_ == kDefaultBlockSize) {
-    if (last_block_ != map_size_ - 1) {
-      last_element_ = 0;
-      ++last_block_;
-      arr_[last_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
-    } else {
-      expand_arr();
-      last_element_ = 0;
+  return last_block_ + blocks;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+size_t Deque<T, Alloc, BlockSize, SpareBlocks>::reserve_front(size_t count) {
+  size_t blocks = count > first_element_
+                      ? (count - first_element_ + kBlockMask) >> kBlockShift
+                      : 0;
+  if (blocks > 0) {
+    reserve_map(true, blocks);
+  }
+  size_t done = 0;
+  try {
+    for (; done < blocks; ++done) {
+      arr_[first_block_ - 1 - done] = allocate_block();
     }
+  } catch (...) {
+    release_front(first_block_ - done);
+    throw;
   }
+  return first_block_ - blocks;
 }
 
-template <typename T, typename Alloc>
-template <typename... Args>
-void Deque<T, Alloc>::emplace_front(Args&&... args) {
-  size_t copy_first_block = first_block_;
-  size_t copy_first_elem = first_element_;
-
-  if (first_element_ == 0) {
-    if (first_block_ == 0) {
-      expand_arr1();
-      first_element_ = kDefaultBlockSize;
-    } else {
-      first_element_ = kDefaultBlockSize;
-      --first_block_;
-      arr_[first_block_] = alloc_traits::allocate(alloc_, kDefaultBlockSize);
-    }
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::release_back(size_t reserved) {
+  for (size_t i = last_block_ + 1; i <= reserved; ++i) {
+    deallocate_block(arr_[i]);
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::release_front(size_t reserved) {
+  for (size_t i = reserved; i < first_block_; ++i) {
+    deallocate_block(arr_[i]);
   }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::grow_back(size_t count) {
+  size_t end = first_pos() + arr_size_ + count;
+  arr_size_ += count;
+  last_block_ = end >> kBlockShift;
+  last_element_ = end & kBlockMask;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::grow_front(size_t count) {
+  size_t start = first_pos() - count;
+  arr_size_ += count;
+  first_block_ = start >> kBlockShift;
+  first_element_ = start & kBlockMask;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::shrink_back(size_t count) {
+  size_t end = first_pos() + arr_size_ - count;
+  destroy_span(end, count);
+  size_t new_last = end >> kBlockShift;
+  for (size_t i = new_last + 1; i <= last_block_; ++i) {
+    deallocate_block(arr_[i]);
+  }
+  arr_size_ -= count;
+  last_block_ = new_last;
+  last_element_ = end & kBlockMask;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::shrink_front(size_t count) {
+  size_t start = first_pos() + count;
+  destroy_span(first_pos(), count);
+  size_t new_first = start >> kBlockShift;
+  for (size_t i = first_block_; i < new_first; ++i) {
+    deallocate_block(arr_[i]);
+  }
+  arr_size_ -= count;
+  first_block_ = new_first;
+  first_element_ = start & kBlockMask;
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+template <typename It>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::construct_span(size_t pos,
+                                                             It& src,
+                                                             size_t count) {
+  size_t done = 0;
   try {
-    alloc_traits::construct(alloc_, arr_[first_block_] + first_element_ - 1,
-                            std::forward<Args>(args)...);
+    while (done < count) {
+      T* block = arr_[(pos + done) >> kBlockShift];
+      size_t from = (pos + done) & kBlockMask;
+      size_t to = std::min(kBlockSize, from + (count - done));
+      for (; from < to; ++from, ++done, ++src) {
+        alloc_traits::construct(alloc_, block + from, *src);
+      }
+    }
   } catch (...) {
-    alloc_traits::destroy(alloc_, arr_[first_block_] + first_element_ - 1);
-    first_block_ = copy_first_block;
-    first_element_ = copy_first_elem;
+    destroy_span(pos, done);
     throw;
   }
-  ++arr_size_;
-  --first_element_;
 }
 
-template <typename T, typename Alloc>
-size_t Deque<T, Alloc>::size() const {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::destroy_span(size_t pos,
+                                                           size_t count) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (size_t i = 0; i < count; ++i) {
+      alloc_traits::destroy(alloc_, slot(pos + i));
+    }
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::move_down(size_t from, size_t to,
+                                                        size_t count) {
+  if constexpr (kTrivial) {
+    while (count > 0) {
+      size_t step = std::min({count, kBlockSize - (from & kBlockMask),
+                              kBlockSize - (to & kBlockMask)});
+      std::memmove(slot(to), slot(from), step * sizeof(T));
+      from += step;
+      to += step;
+      count -= step;
+    }
+  } else {
+    std::move(iter_at(from), iter_at(from + count), iter_at(to));
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+void Deque<T, Alloc, BlockSize, SpareBlocks>::move_up(size_t from, size_t to,
+                                                      size_t count) {
+  if constexpr (kTrivial) {
+    while (count > 0) {
+      size_t step = std::min({count, ((from + count - 1) & kBlockMask) + 1,
+                              ((to + count - 1) & kBlockMask) + 1});
+      count -= step;
+      std::memmove(slot(to + count), slot(from + count), step * sizeof(T));
+    }
+  } else {
+    std::move_backward(iter_at(from), iter_at(from + count),
+                       iter_at(to + count));
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+size_t Deque<T, Alloc, BlockSize, SpareBlocks>::size() const {
   return arr_size_;
 }
 
-template <typename T, typename Alloc>
-bool Deque<T, Alloc>::empty() {
+template <typename T, typename Alloc, size_t BlockSize, size_t SpareBlocks>
+bool Deque<T, Alloc, BlockSize, SpareBlocks>::empty() {
   return arr_size_ == 0;
 }
\ No newline at end of file
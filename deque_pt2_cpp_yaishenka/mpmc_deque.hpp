@@ -0,0 +1,322 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "deque.hpp"
+
+const size_t kUnbounded = 0;
+
+// Queue for any number of producer and consumer threads. Elements live in a
+// list of blocks, each filled once from front to back: producers claim a
+// slot by a CAS on the tail block's fill index, consumers by a CAS on the
+// head block's read index. Moving to the next block, which happens once per
+// BlockSize elements, is the only step done under a mutex.
+//
+// A block whose every slot has been read is reset and kept for reuse rather
+// than returned to the allocator, so a thread that still holds a pointer to
+// it never touches freed memory. Both indices carry the block's generation
+// in their upper half: a thread checks that the block is still the head
+// (tail) after reading an index, and its CAS fails if the block has been
+// reused since. Memory goes back to the allocator in ~MpmcDeque.
+//
+// With a capacity, try_push fails while that many elements are queued: a
+// push reserves a unit of an element counter before it claims a slot, and
+// try_pop gives it back. try_pop may fail while a push into the slot it is
+// waiting for has been claimed but not yet finished.
+template <typename T, typename Alloc = std::allocator<T>,
+          size_t BlockSize = DequeBlockSize<T>()>
+class MpmcDeque {
+  static_assert(std::has_single_bit(BlockSize),
+                "BlockSize must be a power of two");
+
+ public:
+  MpmcDeque(size_t capacity = kUnbounded, const Alloc& alloc = Alloc());
+
+  MpmcDeque(const MpmcDeque&) = delete;
+  MpmcDeque& operator=(const MpmcDeque&) = delete;
+
+  ~MpmcDeque();
+
+  bool try_push(const T& value) { return try_emplace(value); }
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  // Returns false without constructing anything if the queue is bounded
+  // and full.
+  template <typename... Args>
+  bool try_emplace(Args&&... args);
+
+  bool try_pop(T& value);
+
+ private:
+  // A slot holds a value once state is Ready(gen) and is skipped by
+  // consumers once it is Dead(gen), which a push that threw leaves behind.
+  struct Slot {
+    std::atomic<uint64_t> state{0};
+    alignas(T) std::byte data[sizeof(T)];
+
+    T* get() { return std::launder(reinterpret_cast<T*>(data)); }
+  };
+
+  struct Block {
+    alignas(kCacheLine) std::atomic<uint64_t> tail{Pack(1, 0)};
+    alignas(kCacheLine) std::atomic<uint64_t> head{Pack(1, 0)};
+    // Slots read plus one for unlinking from the head; the block is reused
+    // when this reaches BlockSize + 1.
+    std::atomic<size_t> released{0};
+    Block* next = nullptr;
+    Block* owned = nullptr;
+    Slot slots[BlockSize];
+  };
+
+  using alloc_traits = std::allocator_traits<Alloc>;
+  using block_alloc = typename alloc_traits::template rebind_alloc<Block>;
+  using block_traits = std::allocator_traits<block_alloc>;
+
+  static constexpr size_t kBlockSize = BlockSize;
+
+  static constexpr uint64_t Pack(uint64_t gen, uint64_t index) {
+    return gen << 32 | index;
+  }
+  static constexpr uint64_t Gen(uint64_t packed) { return packed >> 32; }
+  static constexpr uint64_t Index(uint64_t packed) {
+    return packed & 0xffffffff;
+  }
+  static constexpr uint64_t Ready(uint64_t gen) { return gen << 1 | 1; }
+  static constexpr uint64_t Dead(uint64_t gen) { return gen << 1; }
+
+  alignas(kCacheLine) std::atomic<Block*> tail_block_;
+  alignas(kCacheLine) std::atomic<Block*> head_block_;
+
+  // Elements pushed and not yet popped, kept only when bounded.
+  alignas(kCacheLine) std::atomic<size_t> count_{0};
+  size_t capacity_;
+
+  alignas(kCacheLine) std::mutex mutex_;
+  Alloc alloc_;
+  Block* free_ = nullptr;
+  Block* owned_ = nullptr;
+
+  bool reserve();
+  void unreserve();
+
+  // Called with mutex_ held.
+  void link_block(Block* last);
+  void unlink_block(Block* first);
+
+  void release(Block* block);
+  void recycle(Block* block);
+
+  Block* allocate_block();
+};
+
+template <typename T, typename Alloc, size_t BlockSize>
+MpmcDeque<T, Alloc, BlockSize>::MpmcDeque(size_t capacity, const Alloc& alloc)
+    : capacity_(capacity), alloc_(alloc) {
+  Block* block = allocate_block();
+  tail_block_.store(block, std::memory_order_relaxed);
+  head_block_.store(block, std::memory_order_relaxed);
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+MpmcDeque<T, Alloc, BlockSize>::~MpmcDeque() {
+  for (Block* block = head_block_.load(std::memory_order_acquire);
+       block != nullptr; block = block->next) {
+    uint64_t gen = Gen(block->head.load(std::memory_order_relaxed));
+    size_t end = Index(block->tail.load(std::memory_order_relaxed));
+    for (size_t index = Index(block->head.load(std::memory_order_relaxed));
+         index < end; ++index) {
+      Slot& slot = block->slots[index];
+      if (slot.state.load(std::memory_order_acquire) == Ready(gen)) {
+        alloc_traits::destroy(alloc_, slot.get());
+      }
+    }
+  }
+  block_alloc alloc(alloc_);
+  while (owned_ != nullptr) {
+    Block* next = owned_->owned;
+    owned_->~Block();
+    block_traits::deallocate(alloc, owned_, 1);
+    owned_ = next;
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+template <typename... Args>
+bool MpmcDeque<T, Alloc, BlockSize>::try_emplace(Args&&... args) {
+  if (!reserve()) {
+    return false;
+  }
+  while (true) {
+    Block* block = tail_block_.load(std::memory_order_acquire);
+    uint64_t tail = block->tail.load(std::memory_order_acquire);
+    if (tail_block_.load(std::memory_order_acquire) != block) {
+      continue;
+    }
+    uint64_t index = Index(tail);
+    if (index == kBlockSize) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (tail_block_.load(std::memory_order_relaxed) == block) {
+        try {
+          link_block(block);
+        } catch (...) {
+          unreserve();
+          throw;
+        }
+      }
+      continue;
+    }
+    if (!block->tail.compare_exchange_weak(tail, tail + 1,
+                                           std::memory_order_acq_rel)) {
+      continue;
+    }
+    Slot& slot = block->slots[index];
+    try {
+      alloc_traits::construct(alloc_, slot.get(),
+                              std::forward<Args>(args)...);
+    } catch (...) {
+      slot.state.store(Dead(Gen(tail)), std::memory_order_release);
+      unreserve();
+      throw;
+    }
+    slot.state.store(Ready(Gen(tail)), std::memory_order_release);
+    return true;
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+bool MpmcDeque<T, Alloc, BlockSize>::try_pop(T& value) {
+  while (true) {
+    Block* block = head_block_.load(std::memory_order_acquire);
+    uint64_t head = block->head.load(std::memory_order_acquire);
+    if (head_block_.load(std::memory_order_acquire) != block) {
+      continue;
+    }
+    uint64_t gen = Gen(head);
+    uint64_t index = Index(head);
+    if (index == kBlockSize) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (head_block_.load(std::memory_order_relaxed) == block) {
+        if (block->next == nullptr) {
+          return false;
+        }
+        unlink_block(block);
+      }
+      continue;
+    }
+    Slot& slot = block->slots[index];
+    uint64_t state = slot.state.load(std::memory_order_acquire);
+    if (state != Ready(gen) && state != Dead(gen)) {
+      uint64_t tail = block->tail.load(std::memory_order_acquire);
+      if (Gen(tail) != gen) {
+        continue;
+      }
+      return false;
+    }
+    if (!block->head.compare_exchange_weak(head, head + 1,
+                                           std::memory_order_acq_rel)) {
+      continue;
+    }
+    if (state == Dead(gen)) {
+      release(block);
+      continue;
+    }
+    T* elem = slot.get();
+    try {
+      value = std::move(*elem);
+    } catch (...) {
+      alloc_traits::destroy(alloc_, elem);
+      release(block);
+      unreserve();
+      throw;
+    }
+    alloc_traits::destroy(alloc_, elem);
+    release(block);
+    unreserve();
+    return true;
+  }
+}
+
+// A CAS loop rather than fetch_add, so that a full queue never shows a
+// count above capacity_.
+template <typename T, typename Alloc, size_t BlockSize>
+bool MpmcDeque<T, Alloc, BlockSize>::reserve() {
+  if (capacity_ == kUnbounded) {
+    return true;
+  }
+  size_t count = count_.load(std::memory_order_relaxed);
+  do {
+    if (count == capacity_) {
+      return false;
+    }
+  } while (!count_.compare_exchange_weak(count, count + 1,
+                                         std::memory_order_relaxed));
+  return true;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+void MpmcDeque<T, Alloc, BlockSize>::unreserve() {
+  if (capacity_ != kUnbounded) {
+    count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+void MpmcDeque<T, Alloc, BlockSize>::link_block(Block* last) {
+  Block* block = free_;
+  if (block != nullptr) {
+    free_ = block->next;
+    block->next = nullptr;
+  } else {
+    block = allocate_block();
+  }
+  last->next = block;
+  tail_block_.store(block, std::memory_order_release);
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+void MpmcDeque<T, Alloc, BlockSize>::unlink_block(Block* first) {
+  head_block_.store(first->next, std::memory_order_release);
+  if (first->released.fetch_add(1, std::memory_order_acq_rel) ==
+      kBlockSize) {
+    recycle(first);
+  }
+}
+
+// The last of the BlockSize + 1 releases hands the block back. All but the
+// unlink happen outside mutex_, so that one takes it here.
+template <typename T, typename Alloc, size_t BlockSize>
+void MpmcDeque<T, Alloc, BlockSize>::release(Block* block) {
+  if (block->released.fetch_add(1, std::memory_order_acq_rel) ==
+      kBlockSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recycle(block);
+  }
+}
+
+// Bumping the generation fails every CAS still aimed at the old one, and
+// makes every slot state stale without touching the slots.
+template <typename T, typename Alloc, size_t BlockSize>
+void MpmcDeque<T, Alloc, BlockSize>::recycle(Block* block) {
+  uint64_t gen = Gen(block->head.load(std::memory_order_relaxed)) + 1;
+  block->released.store(0, std::memory_order_relaxed);
+  block->head.store(Pack(gen, 0), std::memory_order_release);
+  block->tail.store(Pack(gen, 0), std::memory_order_release);
+  block->next = free_;
+  free_ = block;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+typename MpmcDeque<T, Alloc, BlockSize>::Block*
+MpmcDeque<T, Alloc, BlockSize>::allocate_block() {
+  block_alloc alloc(alloc_);
+  Block* block = block_traits::allocate(alloc, 1);
+  ::new (static_cast<void*>(block)) Block;
+  block->owned = owned_;
+  owned_ = block;
+  return block;
+}
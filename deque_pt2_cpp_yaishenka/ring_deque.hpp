@@ -0,0 +1,446 @@
+#pragma once
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "deque.hpp"
+
+const size_t kDefaultRingSize = 8;
+const size_t kDefaultRingThreshold = 256;
+
+// Deque for short queues: elements live in one power-of-two circular buffer
+// indexed by mask until the size exceeds Threshold, after which they move to
+// a block Deque for good. Growing the ring invalidates references, as in
+// std::vector; in block mode the Deque guarantees apply.
+template <typename T, typename Alloc = std::allocator<T>,
+          size_t Threshold = kDefaultRingThreshold>
+class RingDeque {
+  static_assert((Threshold & (Threshold - 1)) == 0 &&
+                    Threshold >= kDefaultRingSize,
+                "Threshold must be a power of two");
+
+ public:
+  template <bool IsConst>
+  class Iterator;
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  iterator begin() { return iterator(this, 0); }
+
+  iterator end() { return iterator(this, size()); }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+
+  const_reverse_iterator crbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  const_reverse_iterator crend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  RingDeque() = default;
+
+  RingDeque(const Alloc& alloc) : alloc_(alloc) {}
+
+  RingDeque(const RingDeque& other);
+
+  RingDeque(RingDeque&& other);
+
+  RingDeque(std::initializer_list<T> init, const Alloc& alloc = Alloc());
+
+  RingDeque& operator=(const RingDeque& other);
+
+  RingDeque& operator=(RingDeque&& other);
+
+  ~RingDeque() { release(); }
+
+  T& operator[](size_t num);
+  const T& operator[](size_t num) const;
+  T& at(size_t num);
+  const T& at(size_t num) const;
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+  void pop_back();
+  void pop_front();
+
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+
+  template <typename... Args>
+  void emplace_front(Args&&... args);
+
+  size_t size() const { return blocks_ ? blocks_->size() : size_; }
+  bool empty() const { return size() == 0; }
+
+  // True once the elements have moved to block storage.
+  bool is_blocked() const { return blocks_.has_value(); }
+
+  Alloc get_allocator() { return alloc_; }
+
+ private:
+  T* ring_ = nullptr;
+  size_t capacity_ = 0;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  std::optional<Deque<T, Alloc>> blocks_;
+  Alloc alloc_;
+  using alloc_traits = std::allocator_traits<Alloc>;
+
+  T* slot(size_t num) const {
+    return ring_ + ((head_ + num) & (capacity_ - 1));
+  }
+
+  // Makes room for one more element, switching to blocks past Threshold.
+  void reserve_one();
+  void to_blocks();
+  void release();
+  void swap(RingDeque& other);
+};
+
+template <typename T, typename Alloc, size_t Threshold>
+template <bool IsConst>
+class RingDeque<T, Alloc, Threshold>::Iterator {
+ public:
+  using container = std::conditional_t<IsConst, const RingDeque, RingDeque>;
+  using is_const = std::conditional_t<IsConst, const T, T>;
+  using value_type = T;
+  using pointer = is_const*;
+  using reference = is_const&;
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+
+  Iterator() = default;
+
+  Iterator(container* deque, size_t index) : deque_(deque), num_(index) {}
+
+  operator Iterator<true>() const { return Iterator<true>(deque_, num_); }
+
+  reference operator*() const { return (*deque_)[num_]; }
+
+  pointer operator->() const { return &(*deque_)[num_]; }
+
+  reference operator[](difference_type value) const {
+    return (*deque_)[num_ + value];
+  }
+
+  Iterator& operator++() {
+    ++num_;
+    return *this;
+  }
+
+  Iterator operator++(int) {
+    Iterator copy(*this);
+    ++num_;
+    return copy;
+  }
+
+  Iterator& operator--() {
+    --num_;
+    return *this;
+  }
+
+  Iterator operator--(int) {
+    Iterator copy(*this);
+    --num_;
+    return copy;
+  }
+
+  Iterator& operator+=(difference_type value) {
+    num_ += value;
+    return *this;
+  }
+
+  Iterator& operator-=(difference_type value) {
+    num_ -= value;
+    return *this;
+  }
+
+  friend Iterator operator+(difference_type value, const Iterator& iter) {
+    return Iterator(iter.deque_, iter.num_ + value);
+  }
+
+  friend Iterator operator+(const Iterator& iter, difference_type value) {
+    return value + iter;
+  }
+
+  friend Iterator operator-(const Iterator& iter, difference_type value) {
+    return Iterator(iter.deque_, iter.num_ - value);
+  }
+
+  friend difference_type operator-(const Iterator& first,
+                                   const Iterator& second) {
+    return static_cast<difference_type>(first.num_ - second.num_);
+  }
+
+  friend bool operator==(const Iterator& first, const Iterator& second) {
+    return first.num_ == second.num_;
+  }
+
+  friend bool operator!=(const Iterator& first, const Iterator& second) {
+    return !(first == second);
+  }
+
+  friend bool operator<(const Iterator& first, const Iterator& second) {
+    return first.num_ < second.num_;
+  }
+
+  friend bool operator>(const Iterator& first, const Iterator& second) {
+    return second < first;
+  }
+
+  friend bool operator<=(const Iterator& first, const Iterator& second) {
+    return !(second < first);
+  }
+
+  friend bool operator>=(const Iterator& first, const Iterator& second) {
+    return !(first < second);
+  }
+
+ private:
+  container* deque_ = nullptr;
+  size_t num_ = 0;
+};
+
+template <typename T, typename Alloc, size_t Threshold>
+RingDeque<T, Alloc, Threshold>::RingDeque(const RingDeque& other)
+    : alloc_(alloc_traits::select_on_container_copy_construction(
+          other.alloc_)) {
+  if (other.blocks_) {
+    blocks_.emplace(alloc_);
+    for (size_t i = 0; i < other.blocks_->size(); ++i) {
+      blocks_->push_back((*other.blocks_)[i]);
+    }
+    return;
+  }
+  for (size_t i = 0; i < other.size_; ++i) {
+    emplace_back(other[i]);
+  }
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+RingDeque<T, Alloc, Threshold>::RingDeque(RingDeque&& other)
+    : ring_(std::exchange(other.ring_, nullptr)),
+      capacity_(std::exchange(other.capacity_, 0)),
+      head_(std::exchange(other.head_, 0)),
+      size_(std::exchange(other.size_, 0)),
+      blocks_(std::move(other.blocks_)),
+      alloc_(std::move(other.alloc_)) {
+  other.blocks_.reset();
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+RingDeque<T, Alloc, Threshold>::RingDeque(std::initializer_list<T> init,
+                                          const Alloc& alloc)
+    : alloc_(alloc) {
+  for (const auto& elem : init) {
+    emplace_back(elem);
+  }
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+RingDeque<T, Alloc, Threshold>& RingDeque<T, Alloc, Threshold>::operator=(
+    const RingDeque& other) {
+  if (this != &other) {
+    RingDeque tmp(other);
+    if (alloc_traits::propagate_on_container_copy_assignment::value) {
+      tmp.alloc_ = other.alloc_;
+    } else {
+      tmp.alloc_ = alloc_;
+    }
+    swap(tmp);
+  }
+  return *this;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+RingDeque<T, Alloc, Threshold>& RingDeque<T, Alloc, Threshold>::operator=(
+    RingDeque&& other) {
+  if (this != &other) {
+    RingDeque tmp(std::move(other));
+    swap(tmp);
+  }
+  return *this;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+T& RingDeque<T, Alloc, Threshold>::operator[](size_t num) {
+  return blocks_ ? (*blocks_)[num] : *slot(num);
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+const T& RingDeque<T, Alloc, Threshold>::operator[](size_t num) const {
+  return blocks_ ? (*blocks_)[num] : *slot(num);
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+T& RingDeque<T, Alloc, Threshold>::at(size_t num) {
+  if (num >= size()) {
+    throw std::out_of_range("out of deque");
+  }
+  return (*this)[num];
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+const T& RingDeque<T, Alloc, Threshold>::at(size_t num) const {
+  if (num >= size()) {
+    throw std::out_of_range("out of deque");
+  }
+  return (*this)[num];
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+template <typename... Args>
+void RingDeque<T, Alloc, Threshold>::emplace_back(Args&&... args) {
+  if (!blocks_ && size_ == capacity_) {
+    // args may refer to an element, which growing moves and frees.
+    T value(std::forward<Args>(args)...);
+    reserve_one();
+    emplace_back(std::move(value));
+    return;
+  }
+  if (blocks_) {
+    blocks_->emplace_back(std::forward<Args>(args)...);
+    return;
+  }
+  alloc_traits::construct(alloc_, slot(size_), std::forward<Args>(args)...);
+  ++size_;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+template <typename... Args>
+void RingDeque<T, Alloc, Threshold>::emplace_front(Args&&... args) {
+  if (!blocks_ && size_ == capacity_) {
+    // args may refer to an element, which growing moves and frees.
+    T value(std::forward<Args>(args)...);
+    reserve_one();
+    emplace_front(std::move(value));
+    return;
+  }
+  if (blocks_) {
+    blocks_->emplace_front(std::forward<Args>(args)...);
+    return;
+  }
+  size_t new_head = (head_ + capacity_ - 1) & (capacity_ - 1);
+  alloc_traits::construct(alloc_, ring_ + new_head,
+                          std::forward<Args>(args)...);
+  head_ = new_head;
+  ++size_;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void RingDeque<T, Alloc, Threshold>::pop_back() {
+  if (blocks_) {
+    blocks_->pop_back();
+    return;
+  }
+  --size_;
+  alloc_traits::destroy(alloc_, slot(size_));
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void RingDeque<T, Alloc, Threshold>::pop_front() {
+  if (blocks_) {
+    blocks_->pop_front();
+    return;
+  }
+  alloc_traits::destroy(alloc_, ring_ + head_);
+  head_ = (head_ + 1) & (capacity_ - 1);
+  --size_;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void RingDeque<T, Alloc, Threshold>::reserve_one() {
+  if (size_ < capacity_) {
+    return;
+  }
+  if (capacity_ == Threshold) {
+    to_blocks();
+    return;
+  }
+  size_t new_cap = capacity_ == 0 ? kDefaultRingSize : 2 * capacity_;
+  T* new_ring = alloc_traits::allocate(alloc_, new_cap);
+  size_t moved = 0;
+  try {
+    for (; moved < size_; ++moved) {
+      alloc_traits::construct(alloc_, new_ring + moved,
+                              std::move_if_noexcept(*slot(moved)));
+    }
+  } catch (...) {
+    for (size_t i = 0; i < moved; ++i) {
+      alloc_traits::destroy(alloc_, new_ring + i);
+    }
+    alloc_traits::deallocate(alloc_, new_ring, new_cap);
+    throw;
+  }
+  size_t size = size_;
+  release();
+  ring_ = new_ring;
+  capacity_ = new_cap;
+  size_ = size;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void RingDeque<T, Alloc, Threshold>::to_blocks() {
+  Deque<T, Alloc> blocks(alloc_);
+  // append_range allocates every block before it moves an element, so a
+  // failed allocation leaves the ring as it was.
+  auto take = [this](size_t num) -> decltype(auto) {
+    return std::move_if_noexcept(*slot(num));
+  };
+  blocks.append_range(std::views::iota(size_t{0}, size_) |
+                      std::views::transform(take));
+  release();
+  blocks_.emplace(std::move(blocks));
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void RingDeque<T, Alloc, Threshold>::release() {
+  for (size_t i = 0; i < size_; ++i) {
+    alloc_traits::destroy(alloc_, slot(i));
+  }
+  if (ring_ != nullptr) {
+    alloc_traits::deallocate(alloc_, ring_, capacity_);
+  }
+  ring_ = nullptr;
+  capacity_ = 0;
+  head_ = 0;
+  size_ = 0;
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void RingDeque<T, Alloc, Threshold>::swap(RingDeque& other) {
+  std::swap(ring_, other.ring_);
+  std::swap(capacity_, other.capacity_);
+  std::swap(head_, other.head_);
+  std::swap(size_, other.size_);
+  std::optional<Deque<T, Alloc>> blocks(std::move(blocks_));
+  blocks_.reset();
+  if (other.blocks_) {
+    blocks_.emplace(std::move(*other.blocks_));
+    other.blocks_.reset();
+  }
+  if (blocks) {
+    other.blocks_.emplace(std::move(*blocks));
+  }
+  std::swap(alloc_, other.alloc_);
+}
@@ -0,0 +1,260 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "deque.hpp"
+
+// Queue for handing elements from exactly one producer thread to exactly
+// one consumer thread without locks. Elements live in a singly linked list
+// of blocks laid out like Deque's; positions grow forever and the block of
+// a position is found by walking the list one block at a time. Blocks the
+// consumer has left are reused by the producer instead of being freed.
+//
+// The producer publishes by a release store to tail_, the consumer by a
+// release store to head_; each side reads the other's index with acquire
+// only when its cached copy runs out. push* may only be called from the
+// producer and try_pop/pop_bulk only from the consumer.
+template <typename T, typename Alloc = std::allocator<T>,
+          size_t BlockSize = DequeBlockSize<T>()>
+class SpscDeque {
+  static_assert(std::has_single_bit(BlockSize),
+                "BlockSize must be a power of two");
+
+ public:
+  SpscDeque(const Alloc& alloc = Alloc());
+
+  SpscDeque(const SpscDeque&) = delete;
+  SpscDeque& operator=(const SpscDeque&) = delete;
+
+  ~SpscDeque();
+
+  void push(const T& value) { emplace(value); }
+  void push(T&& value) { emplace(std::move(value)); }
+
+  template <typename... Args>
+  void emplace(Args&&... args);
+
+  // Constructs the elements one block at a time and publishes them with a
+  // single store, so the consumer sees either none or all of them.
+  template <typename InputIt>
+  void push_bulk(InputIt first, InputIt last);
+
+  bool try_pop(T& value);
+
+  // Moves up to max_count elements to out; returns how many were moved.
+  template <typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max_count);
+
+  // Exact only when called from one of the two sides while the other is
+  // idle; otherwise a snapshot.
+  size_t size() const {
+    // head_ never passes tail_, so reading it first cannot go negative.
+    size_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  bool empty() const { return size() == 0; }
+
+ private:
+  struct Block {
+    Block* next = nullptr;
+    alignas(T) std::byte data[sizeof(T) * BlockSize];
+
+    T* slots() { return std::launder(reinterpret_cast<T*>(data)); }
+  };
+
+  using alloc_traits = std::allocator_traits<Alloc>;
+  using block_alloc = typename alloc_traits::template rebind_alloc<Block>;
+  using block_traits = std::allocator_traits<block_alloc>;
+
+  static constexpr size_t kBlockSize = BlockSize;
+  static constexpr size_t kBlockMask = BlockSize - 1;
+
+  Alloc alloc_;
+
+  // Producer side. recycle_ is the oldest block still linked; it can be
+  // reused once the consumer has moved past it.
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};
+  Block* tail_block_;
+  size_t tail_base_ = 0;
+  Block* recycle_;
+  size_t recycle_base_ = 0;
+  size_t head_cache_ = 0;
+
+  // Consumer side.
+  alignas(kCacheLine) std::atomic<size_t> head_{0};
+  Block* head_block_;
+  size_t head_base_ = 0;
+  size_t tail_cache_ = 0;
+
+  // Returns the slot for position pos, linking a new block first if pos is
+  // the first position past tail_block_.
+  T* producer_slot(size_t pos);
+
+  Block* next_block();
+  Block* allocate_block();
+  void deallocate_block(Block* block);
+};
+
+template <typename T, typename Alloc, size_t BlockSize>
+SpscDeque<T, Alloc, BlockSize>::SpscDeque(const Alloc& alloc)
+    : alloc_(alloc) {
+  tail_block_ = allocate_block();
+  recycle_ = tail_block_;
+  head_block_ = tail_block_;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+SpscDeque<T, Alloc, BlockSize>::~SpscDeque() {
+  size_t tail = tail_.load(std::memory_order_acquire);
+  for (size_t pos = head_.load(std::memory_order_relaxed); pos < tail;
+       ++pos) {
+    if (pos == head_base_ + kBlockSize) {
+      head_block_ = head_block_->next;
+      head_base_ = pos;
+    }
+    alloc_traits::destroy(alloc_, head_block_->slots() + (pos & kBlockMask));
+  }
+  while (recycle_ != nullptr) {
+    Block* next = recycle_->next;
+    deallocate_block(recycle_);
+    recycle_ = next;
+  }
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+template <typename... Args>
+void SpscDeque<T, Alloc, BlockSize>::emplace(Args&&... args) {
+  size_t pos = tail_.load(std::memory_order_relaxed);
+  alloc_traits::construct(alloc_, producer_slot(pos),
+                          std::forward<Args>(args)...);
+  tail_.store(pos + 1, std::memory_order_release);
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+template <typename InputIt>
+void SpscDeque<T, Alloc, BlockSize>::push_bulk(InputIt first, InputIt last) {
+  size_t start = tail_.load(std::memory_order_relaxed);
+  size_t pos = start;
+  Block* block = tail_block_;
+  size_t base = tail_base_;
+  try {
+    for (; first != last; ++first, ++pos) {
+      alloc_traits::construct(alloc_, producer_slot(pos), *first);
+    }
+  } catch (...) {
+    tail_block_ = block;
+    tail_base_ = base;
+    for (size_t undo = start; undo < pos; ++undo) {
+      if (undo == base + kBlockSize) {
+        block = block->next;
+        base = undo;
+      }
+      alloc_traits::destroy(alloc_, block->slots() + (undo & kBlockMask));
+    }
+    throw;
+  }
+  tail_.store(pos, std::memory_order_release);
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+bool SpscDeque<T, Alloc, BlockSize>::try_pop(T& value) {
+  size_t pos = head_.load(std::memory_order_relaxed);
+  if (pos == tail_cache_) {
+    tail_cache_ = tail_.load(std::memory_order_acquire);
+    if (pos == tail_cache_) {
+      return false;
+    }
+  }
+  if (pos == head_base_ + kBlockSize) {
+    head_block_ = head_block_->next;
+    head_base_ = pos;
+  }
+  T* slot = head_block_->slots() + (pos & kBlockMask);
+  value = std::move(*slot);
+  alloc_traits::destroy(alloc_, slot);
+  head_.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+template <typename OutputIt>
+size_t SpscDeque<T, Alloc, BlockSize>::pop_bulk(OutputIt out,
+                                                size_t max_count) {
+  size_t start = head_.load(std::memory_order_relaxed);
+  if (tail_cache_ - start < max_count) {
+    tail_cache_ = tail_.load(std::memory_order_acquire);
+  }
+  size_t end = start + std::min(max_count, tail_cache_ - start);
+  size_t pos = start;
+  try {
+    for (; pos < end; ++pos) {
+      if (pos == head_base_ + kBlockSize) {
+        head_block_ = head_block_->next;
+        head_base_ = pos;
+      }
+      T* slot = head_block_->slots() + (pos & kBlockMask);
+      *out = std::move(*slot);
+      ++out;
+      alloc_traits::destroy(alloc_, slot);
+    }
+  } catch (...) {
+    head_.store(pos, std::memory_order_release);
+    throw;
+  }
+  head_.store(end, std::memory_order_release);
+  return end - start;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+T* SpscDeque<T, Alloc, BlockSize>::producer_slot(size_t pos) {
+  if (pos == tail_base_ + kBlockSize) {
+    // A push_bulk that threw may have left blocks linked past the tail.
+    if (tail_block_->next == nullptr) {
+      tail_block_->next = next_block();
+    }
+    tail_block_ = tail_block_->next;
+    tail_base_ = pos;
+  }
+  return tail_block_->slots() + (pos & kBlockMask);
+}
+
+// The consumer reads a block's next pointer when it pops the first position
+// of the following block, so a block is free only once head_ is past that.
+template <typename T, typename Alloc, size_t BlockSize>
+typename SpscDeque<T, Alloc, BlockSize>::Block*
+SpscDeque<T, Alloc, BlockSize>::next_block() {
+  size_t free_from = recycle_base_ + kBlockSize + 1;
+  if (head_cache_ < free_from) {
+    head_cache_ = head_.load(std::memory_order_acquire);
+  }
+  if (head_cache_ < free_from) {
+    return allocate_block();
+  }
+  Block* block = recycle_;
+  recycle_ = block->next;
+  recycle_base_ += kBlockSize;
+  block->next = nullptr;
+  return block;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+typename SpscDeque<T, Alloc, BlockSize>::Block*
+SpscDeque<T, Alloc, BlockSize>::allocate_block() {
+  block_alloc alloc(alloc_);
+  Block* block = block_traits::allocate(alloc, 1);
+  ::new (static_cast<void*>(block)) Block;
+  return block;
+}
+
+template <typename T, typename Alloc, size_t BlockSize>
+void SpscDeque<T, Alloc, BlockSize>::deallocate_block(Block* block) {
+  block_alloc alloc(alloc_);
+  block->~Block();
+  block_traits::deallocate(alloc, block, 1);
+}
@@ -0,0 +1,1026 @@
+#include "deque.hpp"
+#include "mpmc_deque.hpp"
+#include "ring_deque.hpp"
+#include "spsc_deque.hpp"
+#include "work_stealing_deque.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Allocations left before LimitedAllocator throws; negative means no limit.
+int allocations_left = -1;
+
+template <typename T>
+struct LimitedAllocator {
+  using value_type = T;
+
+  LimitedAllocator() = default;
+
+  template <typename U>
+  LimitedAllocator(const LimitedAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    if (allocations_left == 0) {
+      throw std::bad_alloc();
+    }
+    if (allocations_left > 0) {
+      --allocations_left;
+    }
+    return std::allocator<T>().allocate(count);
+  }
+
+  void deallocate(T* ptr, size_t count) {
+    std::allocator<T>().deallocate(ptr, count);
+  }
+
+  friend bool operator==(const LimitedAllocator&, const LimitedAllocator&) {
+    return true;
+  }
+};
+
+// Allocations made, those of Deque's map of T*, and allocations still
+// held per allocator id.
+int allocations = 0;
+int map_allocations = 0;
+int live_allocations[2];
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+
+  int id = 0;
+
+  CountingAllocator(int id = 0) : id(id) {}
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other) : id(other.id) {}
+
+  T* allocate(size_t count) {
+    ++allocations;
+    if constexpr (std::is_pointer_v<T>) {
+      ++map_allocations;
+    }
+    ++live_allocations[id];
+    return std::allocator<T>().allocate(count);
+  }
+
+  void deallocate(T* ptr, size_t count) {
+    --live_allocations[id];
+    std::allocator<T>().deallocate(ptr, count);
+  }
+
+  friend bool operator==(const CountingAllocator& first,
+                         const CountingAllocator& second) {
+    return first.id == second.id;
+  }
+};
+
+template <typename T, size_t BlockSize>
+void ExpectEqual(Deque<T, std::allocator<T>, BlockSize>& deque,
+                 const std::deque<T>& expected) {
+  ASSERT_EQ(deque.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(deque[i], expected[i]);
+  }
+}
+
+template <typename T, typename Alloc, size_t Threshold>
+void ExpectEqual(const RingDeque<T, Alloc, Threshold>& deque,
+                 const std::deque<T>& expected) {
+  ASSERT_EQ(deque.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(deque[i], expected[i]);
+  }
+  ASSERT_TRUE(std::equal(deque.begin(), deque.end(), expected.begin()));
+}
+
+int MakeInt(unsigned seed) { return seed; }
+
+std::string MakeString(unsigned seed) {
+  // Long enough to live on the heap, so moves are not copies.
+  return std::to_string(seed) + std::string(24, 'x');
+}
+
+// Random range operations at every position, checked against std::deque.
+// Small blocks make every shift cross block boundaries.
+template <typename T, size_t BlockSize>
+void CompareRanges(T (*make)(unsigned)) {
+  std::mt19937 rng(BlockSize);
+  Deque<T, std::allocator<T>, BlockSize> deque;
+  std::deque<T> expected;
+  for (int step = 0; step < 2000; ++step) {
+    std::vector<T> values(rng() % (3 * BlockSize));
+    for (T& value : values) {
+      value = make(rng());
+    }
+    size_t pos = rng() % (expected.size() + 1);
+    switch (rng() % 6) {
+      case 0:
+        deque.append_range(values);
+        expected.insert(expected.end(), values.begin(), values.end());
+        break;
+      case 1:
+        deque.prepend_range(values);
+        expected.insert(expected.begin(), values.begin(), values.end());
+        break;
+      case 2: {
+        auto iter = deque.insert(deque.begin() + pos, values.begin(),
+                                 values.end());
+        ASSERT_EQ(iter - deque.begin(), pos);
+        // libstdc++ self-move-assigns elements on an empty insert.
+        if (!values.empty()) {
+          expected.insert(expected.begin() + pos, values.begin(),
+                          values.end());
+        }
+        break;
+      }
+      case 3: {
+        size_t count = std::min(expected.size() - pos,
+                                static_cast<size_t>(rng() % (3 * BlockSize)));
+        auto iter = deque.erase(deque.begin() + pos,
+                                deque.begin() + pos + count);
+        ASSERT_EQ(iter - deque.begin(), pos);
+        expected.erase(expected.begin() + pos,
+                       expected.begin() + pos + count);
+        break;
+      }
+      case 4: {
+        T value = make(rng());
+        deque.insert(deque.begin() + pos, value);
+        expected.insert(expected.begin() + pos, value);
+        break;
+      }
+      case 5:
+        if (rng() % 10 == 0) {
+          deque.assign(values.begin(), values.end());
+          expected.assign(values.begin(), values.end());
+        }
+        break;
+    }
+    ExpectEqual(deque, expected);
+  }
+}
+
+// Copies succeed until `copies_left` reaches zero.
+int copies_left = -1;
+
+struct ThrowingCopy {
+  std::string value;
+
+  ThrowingCopy(int seed) : value(MakeString(seed)) {}
+
+  ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("copy");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+  }
+
+  ThrowingCopy(ThrowingCopy&&) noexcept = default;
+  ThrowingCopy& operator=(const ThrowingCopy&) = default;
+  ThrowingCopy& operator=(ThrowingCopy&&) noexcept = default;
+};
+
+// Every producer pushes its id and a running number; every consumer checks
+// that it sees each producer's numbers in order, and at the end every
+// element must have been taken exactly once.
+template <size_t BlockSize>
+void RunMpmc(size_t capacity, int producers, int consumers, size_t count) {
+  MpmcDeque<uint64_t, std::allocator<uint64_t>, BlockSize> queue(capacity);
+  std::vector<std::atomic<int>> taken(producers * count);
+  std::atomic<size_t> popped{0};
+  std::atomic<bool> in_order{true};
+  std::vector<std::thread> threads;
+  for (int id = 0; id < producers; ++id) {
+    threads.emplace_back([&queue, id, count] {
+      for (uint64_t i = 0; i < count; ++i) {
+        while (!queue.try_push(static_cast<uint64_t>(id) << 32 | i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int id = 0; id < consumers; ++id) {
+    threads.emplace_back([&, producers, count] {
+      std::vector<int64_t> last(producers, -1);
+      uint64_t value;
+      while (popped.load() < producers * count) {
+        if (!queue.try_pop(value)) {
+          std::this_thread::yield();
+          continue;
+        }
+        size_t producer = value >> 32;
+        int64_t number = value & 0xffffffff;
+        if (number <= last[producer]) {
+          in_order = false;
+        }
+        last[producer] = number;
+        taken[producer * count + number].fetch_add(1);
+        popped.fetch_add(1);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(in_order.load());
+  for (std::atomic<int>& times : taken) {
+    ASSERT_EQ(times.load(), 1);
+  }
+  uint64_t value;
+  ASSERT_FALSE(queue.try_pop(value));
+}
+
+// Blocks hold 4 KB, rounded down to a power of two, and at least 16
+// elements however large T is.
+static_assert(DequeBlockSize<char>() == 4096);
+static_assert(DequeBlockSize<int>() == 1024);
+static_assert(DequeBlockSize<std::array<char, 24>>() == 128);
+static_assert(DequeBlockSize<std::array<char, 200>>() == 16);
+static_assert(DequeBlockSize<std::array<char, 300>>() == 16);
+static_assert(DequeBlockSize<std::array<char, 10000>>() == 16);
+
+}  // namespace
+
+TEST(Deque, PushFrontAllocationFailure) {
+  Deque<int, LimitedAllocator<int>, 16, 0> deque;
+  for (int i = 0; i < 16; ++i) {
+    deque.push_front(i);
+  }
+  allocations_left = 0;
+  ASSERT_THROW(deque.push_front(16), std::bad_alloc);
+  allocations_left = -1;
+  ASSERT_EQ(deque.size(), 16);
+  deque.push_front(16);
+  ASSERT_EQ(deque.size(), 17);
+  for (int i = 0; i < 17; ++i) {
+    ASSERT_EQ(deque[i], 16 - i);
+  }
+}
+
+TEST(Deque, PushBackAllocationFailure) {
+  Deque<int, LimitedAllocator<int>, 16, 0> deque;
+  for (int i = 0; i < 15; ++i) {
+    deque.push_back(i);
+  }
+  allocations_left = 0;
+  ASSERT_THROW(deque.push_back(15), std::bad_alloc);
+  allocations_left = -1;
+  ASSERT_EQ(deque.size(), 15);
+  deque.push_back(15);
+  deque.push_back(16);
+  for (int i = 0; i < 17; ++i) {
+    ASSERT_EQ(deque[i], i);
+  }
+}
+
+// for_each_segment yields one span per block, which shows the block size.
+// Blocks freed at one end are reused at the other, so a queue of steady
+// length stops allocating once it is warm.
+TEST(Deque, SpareBlocksStopAllocations) {
+  Deque<int, CountingAllocator<int>, 16> deque;
+  for (int i = 0; i < 100; ++i) {
+    deque.push_back(i);
+  }
+  for (int i = 100; i < 200; ++i) {
+    deque.push_back(i);
+    deque.pop_front();
+  }
+  int warm = allocations;
+  for (int i = 200; i < 100000; ++i) {
+    deque.push_back(i);
+    deque.pop_front();
+  }
+  ASSERT_EQ(allocations, warm);
+  for (int i = 100000; i < 200000; ++i) {
+    deque.push_front(i);
+    deque.pop_back();
+  }
+  ASSERT_EQ(allocations, warm);
+  ASSERT_EQ(deque.size(), 100);
+}
+
+// A queue that drifts through the map recenters it in place instead of
+// growing it, however long it runs. No spare blocks, so blocks come and go.
+TEST(Deque, MapStaysBoundedInFifo) {
+  Deque<int, CountingAllocator<int>, 16, 0> deque;
+  for (int i = 0; i < 1000; ++i) {
+    deque.push_back(i);
+  }
+  int warm = map_allocations;
+  for (int i = 0; i < 1000000; ++i) {
+    deque.push_back(i);
+    deque.pop_front();
+  }
+  for (int i = 0; i < 1000000; ++i) {
+    deque.push_front(i);
+    deque.pop_back();
+  }
+  ASSERT_LE(map_allocations, warm + 1);
+  ASSERT_EQ(deque.size(), 1000);
+}
+
+// Spare blocks and the map go back to the allocator that made them.
+TEST(Deque, MoveAssignmentReleasesSpareBlocks) {
+  {
+    Deque<std::string, CountingAllocator<std::string>, 4> deque(
+        CountingAllocator<std::string>(0));
+    for (int i = 0; i < 40; ++i) {
+      deque.push_back(MakeString(i));
+    }
+    for (int i = 0; i < 30; ++i) {
+      deque.pop_front();
+    }
+    Deque<std::string, CountingAllocator<std::string>, 4> other(
+        CountingAllocator<std::string>(1));
+    for (int i = 0; i < 20; ++i) {
+      other.push_front(MakeString(i));
+    }
+    for (int i = 0; i < 10; ++i) {
+      other.pop_back();
+    }
+    deque = std::move(other);
+    ASSERT_EQ(live_allocations[0], 0);
+    ASSERT_EQ(deque.size(), 10);
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_EQ(deque[i], MakeString(19 - i));
+    }
+    for (int i = 0; i < 40; ++i) {
+      deque.push_back(MakeString(i));
+    }
+    ASSERT_EQ(deque.size(), 50);
+  }
+  ASSERT_EQ(live_allocations[0], 0);
+  ASSERT_EQ(live_allocations[1], 0);
+}
+
+TEST(Deque, BlockSize) {
+  auto segments = [](auto& deque) {
+    std::vector<size_t> sizes;
+    deque.for_each_segment(
+        [&sizes](auto span) { sizes.push_back(span.size()); });
+    return sizes;
+  };
+  Deque<int, std::allocator<int>, 64> deque;
+  for (int i = 0; i < 200; ++i) {
+    deque.push_back(i);
+  }
+  ASSERT_EQ(segments(deque), (std::vector<size_t>{64, 64, 64, 8}));
+  deque.push_front(-1);
+  ASSERT_EQ(segments(deque), (std::vector<size_t>{1, 64, 64, 64, 8}));
+
+  Deque<std::array<char, 300>> large(40);
+  ASSERT_EQ(segments(large), (std::vector<size_t>{16, 16, 8}));
+  Deque<char> small(5000, 'x');
+  ASSERT_EQ(segments(small), (std::vector<size_t>{4096, 904}));
+}
+
+// The block-wise algorithms must match the std ones on every range: empty,
+// inside one block, and from the middle of one block to the middle of
+// another.
+TEST(Deque, SegmentedAlgorithms) {
+  const int kSize = 100;
+  std::deque<int> expected;
+  auto make = [&expected] {
+    Deque<int, std::allocator<int>, 8> deque;
+    for (int i = 0; i < kSize; ++i) {
+      deque.push_back(i * 7 % 31);
+    }
+    for (int i = 0; i < 5; ++i) {
+      deque.pop_front();
+    }
+    expected.assign(deque.begin(), deque.end());
+    return deque;
+  };
+  make();
+  const size_t size = expected.size();
+  for (size_t from : {size_t(0), size_t(1), size_t(3), size_t(8), size_t(13),
+                      size_t(40), size - 1, size}) {
+    for (size_t to = from; to <= size; to += 1 + to % 5) {
+      auto deque = make();
+      auto first = deque.cbegin() + from;
+      auto last = deque.cbegin() + to;
+      auto std_first = expected.begin() + from;
+      auto std_last = expected.begin() + to;
+
+      std::vector<int> copied;
+      copy(first, last, std::back_inserter(copied));
+      ASSERT_TRUE(std::equal(copied.begin(), copied.end(), std_first,
+                             std_last));
+
+      std::vector<int> segmented;
+      for_each_segment(first, last, [&segmented](std::span<const int> span) {
+        ASSERT_LE(span.size(), 8);
+        segmented.insert(segmented.end(), span.begin(), span.end());
+      });
+      ASSERT_EQ(segmented, copied);
+
+      ASSERT_EQ(accumulate(first, last, int64_t(1)),
+                std::accumulate(std_first, std_last, int64_t(1)));
+
+      for (int value : {0, 5, 30, 31}) {
+        ASSERT_EQ(find(first, last, value) - deque.cbegin(),
+                  std::find(std_first, std_last, value) - expected.begin());
+      }
+
+      fill(deque.begin() + from, deque.begin() + to, -1);
+      std::fill(std_first, std_last, -1);
+      ExpectEqual(deque, expected);
+    }
+  }
+}
+
+TEST(Deque, RangesTrivial) {
+  CompareRanges<int, 1>(MakeInt);
+  CompareRanges<int, 2>(MakeInt);
+  CompareRanges<int, 4>(MakeInt);
+  CompareRanges<int, 16>(MakeInt);
+  CompareRanges<int, DequeBlockSize<int>()>(MakeInt);
+}
+
+TEST(Deque, RangesNonTrivial) {
+  CompareRanges<std::string, 1>(MakeString);
+  CompareRanges<std::string, 4>(MakeString);
+  CompareRanges<std::string, 16>(MakeString);
+  CompareRanges<std::string, 64>(MakeString);
+  CompareRanges<std::string, DequeBlockSize<std::string>()>(MakeString);
+}
+
+// Inserting near either end shifts that end, across several blocks.
+TEST(Deque, InsertShiftsShorterSide) {
+  for (size_t size : {1, 15, 16, 17, 40}) {
+    for (size_t count : {1, 5, 16, 33}) {
+      for (size_t pos : {size_t(1), size / 2, size - 1}) {
+        Deque<int, std::allocator<int>, 16> deque;
+        std::deque<int> expected;
+        for (size_t i = 0; i < size; ++i) {
+          deque.push_back(i);
+          expected.push_back(i);
+        }
+        // Start in the middle of a block.
+        deque.pop_front();
+        expected.pop_front();
+        std::vector<int> values(count, -1);
+        size_t at = std::min(pos, expected.size());
+        deque.insert(deque.begin() + at, values.begin(), values.end());
+        expected.insert(expected.begin() + at, values.begin(), values.end());
+        ExpectEqual(deque, expected);
+        size_t erase = std::min(count, expected.size() - at);
+        deque.erase(deque.begin() + at, deque.begin() + at + erase);
+        expected.erase(expected.begin() + at, expected.begin() + at + erase);
+        ExpectEqual(deque, expected);
+      }
+    }
+  }
+}
+
+TEST(Deque, RangesFromBidirectionalIterators) {
+  std::list<std::string> list{"a", "b", "c"};
+  Deque<std::string> deque{"x"};
+  deque.append_range(list);
+  deque.prepend_range(list);
+  deque.insert(deque.begin() + 3, list.begin(), list.end());
+  std::vector<std::string> expected{"a", "b", "c", "a", "b",
+                                    "c", "x", "a", "b", "c"};
+  ASSERT_EQ(deque.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(deque[i], expected[i]);
+  }
+}
+
+// istream_iterator can be read only once, so nothing may count the range
+// before consuming it.
+TEST(Deque, RangesFromInputIterators) {
+  using Input = std::istream_iterator<int>;
+  Deque<int, std::allocator<int>, 4> deque;
+  std::deque<int> expected;
+  for (int i = 0; i < 10; ++i) {
+    deque.push_back(i);
+    expected.push_back(i);
+  }
+  std::istringstream stream("100 200 300");
+  auto iter = deque.insert(deque.begin() + 5, Input(stream), Input());
+  ASSERT_EQ(iter - deque.begin(), 5);
+  expected.insert(expected.begin() + 5, {100, 200, 300});
+  ExpectEqual(deque, expected);
+
+  std::istringstream front("-1 -2 -3 -4 -5");
+  iter = deque.insert(deque.begin() + 1, Input(front), Input());
+  ASSERT_EQ(iter - deque.begin(), 1);
+  expected.insert(expected.begin() + 1, {-1, -2, -3, -4, -5});
+  ExpectEqual(deque, expected);
+
+  std::istringstream empty("");
+  deque.insert(deque.begin() + 2, Input(empty), Input());
+  ExpectEqual(deque, expected);
+
+  std::istringstream back("7 8 9 10 11 12");
+  deque.append_range(std::ranges::subrange(Input(back), Input()));
+  expected.insert(expected.end(), {7, 8, 9, 10, 11, 12});
+  ExpectEqual(deque, expected);
+
+  std::istringstream prepend("20 21 22 23 24 25");
+  deque.prepend_range(std::views::istream<int>(prepend));
+  expected.insert(expected.begin(), {20, 21, 22, 23, 24, 25});
+  ExpectEqual(deque, expected);
+
+  std::istringstream assign("5 6 7");
+  deque.assign(Input(assign), Input());
+  ExpectEqual(deque, std::deque<int>{5, 6, 7});
+}
+
+// emplace, erase and pops only ever move elements, so move-only T works.
+TEST(Deque, MoveOnly) {
+  using Ptr = std::unique_ptr<int>;
+  Deque<Ptr, std::allocator<Ptr>, 4> deque;
+  std::deque<int> expected;
+  auto check = [&deque, &expected] {
+    ASSERT_EQ(deque.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(*deque[i], expected[i]);
+    }
+  };
+  for (int i = 0; i < 20; ++i) {
+    deque.emplace(deque.end(), new int(i));
+    expected.push_back(i);
+    deque.emplace(deque.begin(), new int(-i));
+    expected.push_front(-i);
+    auto iter = deque.emplace(deque.begin() + deque.size() / 3,
+                              std::make_unique<int>(100 + i));
+    ASSERT_EQ(**iter, 100 + i);
+    expected.insert(expected.begin() + expected.size() / 3, 100 + i);
+    deque.emplace_back(new int(200 + i));
+    expected.push_back(200 + i);
+  }
+  check();
+  auto iter = deque.erase(deque.begin() + 10, deque.begin() + 50);
+  ASSERT_EQ(iter - deque.begin(), 10);
+  expected.erase(expected.begin() + 10, expected.begin() + 50);
+  check();
+  for (int i = 0; i < 15; ++i) {
+    deque.pop_front();
+    expected.pop_front();
+    deque.pop_back();
+    expected.pop_back();
+  }
+  check();
+  deque.erase(deque.begin() + 1);
+  expected.erase(expected.begin() + 1);
+  check();
+}
+
+TEST(Deque, AppendRangeStrongGuarantee) {
+  std::vector<ThrowingCopy> values;
+  for (int i = 0; i < 50; ++i) {
+    values.emplace_back(100 + i);
+  }
+  for (int fail_at = 0; fail_at < 50; fail_at += 7) {
+    Deque<ThrowingCopy, std::allocator<ThrowingCopy>, 4> deque;
+    for (int i = 0; i < 10; ++i) {
+      deque.emplace_back(i);
+    }
+    for (int i = 0; i < 3; ++i) {
+      deque.pop_front();
+    }
+    copies_left = fail_at;
+    ASSERT_THROW(deque.append_range(values), std::runtime_error);
+    copies_left = fail_at;
+    ASSERT_THROW(deque.prepend_range(values), std::runtime_error);
+    copies_left = -1;
+    ASSERT_EQ(deque.size(), 7);
+    for (int i = 0; i < 7; ++i) {
+      ASSERT_EQ(deque[i].value, MakeString(3 + i));
+    }
+    deque.append_range(values);
+    deque.prepend_range(values);
+    ASSERT_EQ(deque.size(), 107);
+  }
+}
+
+// Pushes and pops at both ends wrap the ring around, grow it from its
+// default size and finally move the elements to blocks.
+TEST(RingDeque, CompareWithDeque) {
+  std::mt19937 rng(0);
+  RingDeque<std::string, std::allocator<std::string>, 64> deque;
+  std::deque<std::string> expected;
+  for (int step = 0; step < 4000; ++step) {
+    // Grow on average, so that the size passes Threshold halfway through.
+    unsigned op = rng() % (step < 2000 ? 5 : 9);
+    if (expected.empty() || op < 2) {
+      std::string value = MakeString(step);
+      deque.push_back(value);
+      expected.push_back(value);
+    } else if (op < 4) {
+      std::string value = MakeString(step);
+      deque.push_front(value);
+      expected.push_front(value);
+    } else if (op % 2 == 0) {
+      deque.pop_back();
+      expected.pop_back();
+    } else {
+      deque.pop_front();
+      expected.pop_front();
+    }
+    if (expected.size() > 64) {
+      ASSERT_TRUE(deque.is_blocked());
+    }
+    ExpectEqual(deque, expected);
+  }
+  ASSERT_TRUE(deque.is_blocked());
+}
+
+// A ring of the default size allocates once; wrapping around it does not.
+TEST(RingDeque, WrapAroundAndGrowth) {
+  RingDeque<int, LimitedAllocator<int>, 16> deque;
+  std::deque<int> expected;
+  deque.push_back(0);
+  expected.push_back(0);
+  allocations_left = 0;
+  for (int i = 1; i < 8; ++i) {
+    deque.push_back(i);
+    expected.push_back(i);
+  }
+  for (int i = 0; i < 20; ++i) {
+    deque.pop_front();
+    expected.pop_front();
+    deque.push_back(8 + i);
+    expected.push_back(8 + i);
+    deque.pop_back();
+    expected.pop_back();
+    deque.push_front(-i);
+    expected.push_front(-i);
+  }
+  ExpectEqual(deque, expected);
+  ASSERT_THROW(deque.push_back(100), std::bad_alloc);
+  ASSERT_THROW(deque.push_front(100), std::bad_alloc);
+  allocations_left = -1;
+  ExpectEqual(deque, expected);
+  for (int i = 0; i < 8; ++i) {
+    deque.push_back(100 + i);
+    expected.push_back(100 + i);
+  }
+  ASSERT_FALSE(deque.is_blocked());
+  ExpectEqual(deque, expected);
+}
+
+TEST(RingDeque, SwitchesToBlocksAtThreshold) {
+  RingDeque<int, std::allocator<int>, 16> deque;
+  std::deque<int> expected;
+  for (int i = 0; i < 16; ++i) {
+    deque.push_front(i);
+    expected.push_front(i);
+  }
+  ASSERT_FALSE(deque.is_blocked());
+  deque.push_front(16);
+  expected.push_front(16);
+  ASSERT_TRUE(deque.is_blocked());
+  ExpectEqual(deque, expected);
+  while (!expected.empty()) {
+    deque.pop_back();
+    expected.pop_back();
+  }
+  // Block storage is kept once it is in use.
+  ASSERT_TRUE(deque.is_blocked());
+  ASSERT_TRUE(deque.empty());
+}
+
+// The argument refers into the ring that growing frees.
+TEST(RingDeque, PushOwnElement) {
+  RingDeque<std::string, std::allocator<std::string>, 16> deque;
+  std::deque<std::string> expected;
+  for (int i = 0; i < 8; ++i) {
+    deque.push_back(MakeString(i));
+    expected.push_back(MakeString(i));
+  }
+  deque.push_back(deque[0]);
+  expected.push_back(expected[0]);
+  ExpectEqual(deque, expected);
+  while (expected.size() < 16) {
+    deque.push_front(deque[expected.size() - 1]);
+    expected.push_front(expected[expected.size() - 1]);
+  }
+  ASSERT_FALSE(deque.is_blocked());
+  deque.push_front(deque[15]);
+  expected.push_front(expected[15]);
+  ASSERT_TRUE(deque.is_blocked());
+  ExpectEqual(deque, expected);
+
+  RingDeque<std::string, std::allocator<std::string>, 16> ring;
+  for (int i = 0; i < 16; ++i) {
+    ring.push_back(MakeString(i));
+  }
+  ring.push_back(ring[3]);
+  ASSERT_TRUE(ring.is_blocked());
+  ASSERT_EQ(ring[16], MakeString(3));
+}
+
+TEST(RingDeque, CopyAndMove) {
+  for (size_t size : {0, 5, 16, 40}) {
+    RingDeque<std::string, std::allocator<std::string>, 16> deque;
+    std::deque<std::string> expected;
+    for (size_t i = 0; i < size; ++i) {
+      deque.push_front(MakeString(i));
+      expected.push_front(MakeString(i));
+    }
+    auto copy = deque;
+    ExpectEqual(copy, expected);
+    ExpectEqual(deque, expected);
+    auto moved = std::move(copy);
+    ExpectEqual(moved, expected);
+    ASSERT_TRUE(copy.empty());
+    RingDeque<std::string, std::allocator<std::string>, 16> assigned{"a"};
+    assigned = deque;
+    ExpectEqual(assigned, expected);
+    assigned = RingDeque<std::string, std::allocator<std::string>, 16>{"a"};
+    ExpectEqual(assigned, std::deque<std::string>{"a"});
+    assigned = std::move(moved);
+    ExpectEqual(assigned, expected);
+    assigned.push_back("b");
+    ASSERT_EQ(assigned.size(), size + 1);
+  }
+}
+
+TEST(RingDeque, At) {
+  RingDeque<int, std::allocator<int>, 8> deque;
+  ASSERT_THROW(deque.at(0), std::out_of_range);
+  for (int i = 0; i < 8; ++i) {
+    deque.push_back(i);
+  }
+  const auto& ring = deque;
+  ASSERT_EQ(ring.at(7), 7);
+  ASSERT_THROW(ring.at(8), std::out_of_range);
+  deque.push_back(8);
+  ASSERT_TRUE(deque.is_blocked());
+  ASSERT_EQ(deque.at(8), 8);
+  ASSERT_THROW(deque.at(9), std::out_of_range);
+}
+
+// A push that throws while growing or while moving to blocks leaves the
+// elements as they were.
+TEST(RingDeque, StrongGuarantee) {
+  RingDeque<ThrowingCopy, std::allocator<ThrowingCopy>, 16> deque;
+  ThrowingCopy value(-1);
+  for (int size = 0; size < 20; ++size) {
+    copies_left = 0;
+    ASSERT_THROW(deque.push_back(value), std::runtime_error);
+    ASSERT_THROW(deque.push_front(value), std::runtime_error);
+    copies_left = -1;
+    ASSERT_EQ(deque.size(), size);
+    for (int i = 0; i < size; ++i) {
+      ASSERT_EQ(deque[i].value, MakeString(i));
+    }
+    deque.emplace_back(size);
+  }
+
+  // The default block of std::string holds 128, so moving 128 elements
+  // needs a second block, which fails after 127 have moved.
+  RingDeque<std::string, LimitedAllocator<std::string>, 128> ring;
+  std::deque<std::string> expected;
+  for (int i = 0; i < 128; ++i) {
+    ring.push_back(MakeString(i));
+    expected.push_back(MakeString(i));
+  }
+  allocations_left = 1;
+  ASSERT_THROW(ring.push_back(MakeString(128)), std::bad_alloc);
+  allocations_left = -1;
+  ASSERT_FALSE(ring.is_blocked());
+  ExpectEqual(ring, expected);
+  ring.push_back(MakeString(128));
+  expected.push_back(MakeString(128));
+  ASSERT_TRUE(ring.is_blocked());
+  ExpectEqual(ring, expected);
+}
+
+TEST(SpscDeque, OrderAcrossThreads) {
+  const size_t kCount = 1 << 20;
+  SpscDeque<size_t, std::allocator<size_t>, 16> queue;
+  std::thread producer([&queue, kCount] {
+    for (size_t i = 0; i < kCount; ++i) {
+      queue.push(i);
+    }
+  });
+  size_t value;
+  for (size_t expected = 0; expected < kCount;) {
+    if (queue.try_pop(value)) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    }
+  }
+  producer.join();
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(SpscDeque, BulkOrderAcrossThreads) {
+  const size_t kCount = 1 << 20;
+  SpscDeque<size_t, std::allocator<size_t>, 16> queue;
+  std::thread producer([&queue, kCount] {
+    std::vector<size_t> batch;
+    for (size_t i = 0; i < kCount; i += batch.size()) {
+      batch.resize(std::min<size_t>(1 + i % 37, kCount - i));
+      for (size_t j = 0; j < batch.size(); ++j) {
+        batch[j] = i + j;
+      }
+      queue.push_bulk(batch.begin(), batch.end());
+    }
+  });
+  std::vector<size_t> batch(29);
+  for (size_t expected = 0; expected < kCount;) {
+    size_t count = queue.pop_bulk(batch.begin(), batch.size());
+    for (size_t j = 0; j < count; ++j) {
+      ASSERT_EQ(batch[j], expected);
+      ++expected;
+    }
+  }
+  producer.join();
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(SpscDeque, PushBulkRollback) {
+  SpscDeque<ThrowingCopy, std::allocator<ThrowingCopy>, 16> queue;
+  std::vector<ThrowingCopy> values;
+  for (int i = 0; i < 40; ++i) {
+    values.emplace_back(i);
+  }
+  queue.push(ThrowingCopy(-1));
+  // The batch crosses into a second block before it throws.
+  copies_left = 20;
+  ASSERT_THROW(queue.push_bulk(values.begin(), values.end()),
+               std::runtime_error);
+  copies_left = -1;
+  ASSERT_EQ(queue.size(), 1);
+  queue.push(ThrowingCopy(1000));
+  queue.push_bulk(values.begin(), values.end());
+  ThrowingCopy value(0);
+  ASSERT_TRUE(queue.try_pop(value));
+  ASSERT_EQ(value.value, MakeString(-1));
+  ASSERT_TRUE(queue.try_pop(value));
+  ASSERT_EQ(value.value, MakeString(1000));
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_TRUE(queue.try_pop(value));
+    ASSERT_EQ(value.value, MakeString(i));
+  }
+  ASSERT_FALSE(queue.try_pop(value));
+}
+
+TEST(SpscDeque, DestroyNonEmpty) {
+  using Ptr = std::unique_ptr<std::string>;
+  SpscDeque<Ptr, std::allocator<Ptr>, 16> queue;
+  for (int i = 0; i < 100; ++i) {
+    queue.push(std::make_unique<std::string>(MakeString(i)));
+  }
+  std::unique_ptr<std::string> value;
+  for (int i = 0; i < 30; ++i) {
+    ASSERT_TRUE(queue.try_pop(value));
+    ASSERT_EQ(*value, MakeString(i));
+  }
+  ASSERT_EQ(queue.size(), 70);
+}
+
+TEST(MpmcDeque, UnboundedExactlyOnce) {
+  RunMpmc<16>(kUnbounded, 4, 4, 50000);
+  RunMpmc<16>(kUnbounded, 1, 3, 50000);
+  RunMpmc<16>(kUnbounded, 3, 1, 50000);
+  RunMpmc<512>(kUnbounded, 4, 4, 50000);
+}
+
+TEST(MpmcDeque, BoundedExactlyOnce) {
+  RunMpmc<16>(1, 4, 4, 20000);
+  RunMpmc<16>(40, 4, 4, 50000);
+  RunMpmc<16>(40, 3, 1, 50000);
+}
+
+TEST(MpmcDeque, BoundedCapacity) {
+  for (size_t capacity : {1, 5, 16, 17, 100}) {
+    MpmcDeque<int, std::allocator<int>, 16> queue(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+      ASSERT_TRUE(queue.try_push(i));
+    }
+    ASSERT_FALSE(queue.try_push(-1));
+    int value;
+    ASSERT_TRUE(queue.try_pop(value));
+    ASSERT_EQ(value, 0);
+    ASSERT_TRUE(queue.try_push(-1));
+    ASSERT_FALSE(queue.try_push(-1));
+  }
+}
+
+TEST(MpmcDeque, ThrowingConstructor) {
+  MpmcDeque<ThrowingCopy, std::allocator<ThrowingCopy>, 16> queue(20);
+  ThrowingCopy value(0);
+  int pushed = 0;
+  for (int i = 0; i < 60; ++i) {
+    ThrowingCopy element(i);
+    copies_left = i % 3 == 0 ? 0 : -1;
+    try {
+      pushed += queue.try_push(element);
+    } catch (const std::runtime_error&) {
+    }
+    copies_left = -1;
+    if (pushed == 20) {
+      for (int j = 0; j < 10; ++j) {
+        ASSERT_TRUE(queue.try_pop(value));
+      }
+      pushed -= 10;
+    }
+  }
+  int left = 0;
+  for (; queue.try_pop(value); ++left) {
+  }
+  // Failed pushes neither leave an element nor use up capacity.
+  ASSERT_EQ(left, pushed);
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(queue.try_push(value));
+  }
+}
+
+TEST(MpmcDeque, DestroyNonEmpty) {
+  using Ptr = std::unique_ptr<std::string>;
+  MpmcDeque<Ptr, std::allocator<Ptr>, 16> queue;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(queue.try_emplace(new std::string(MakeString(i))));
+  }
+  Ptr value;
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_TRUE(queue.try_pop(value));
+    ASSERT_EQ(*value, MakeString(i));
+  }
+}
+
+TEST(WorkStealingDeque, OwnerEnds) {
+  WorkStealingDeque<int> deque(2);
+  for (int i = 0; i < 100; ++i) {
+    deque.push(i);
+  }
+  ASSERT_EQ(deque.steal(), 0);
+  ASSERT_EQ(deque.pop(), 99);
+  ASSERT_EQ(deque.size(), 98);
+  for (int i = 98; i >= 1; --i) {
+    ASSERT_EQ(deque.pop(), i);
+  }
+  ASSERT_FALSE(deque.pop());
+  ASSERT_FALSE(deque.steal());
+}
+
+// The owner pushes and now and then pops while thieves steal; every item
+// must be taken exactly once.
+TEST(WorkStealingDeque, StealExactlyOnce) {
+  const int kCount = 200000;
+  const int kThieves = 3;
+  WorkStealingDeque<uint32_t> deque(4);
+  std::vector<std::atomic<int>> taken(kCount);
+  std::atomic<bool> done{false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThieves; ++i) {
+    thieves.emplace_back([&] {
+      while (!done.load()) {
+        if (std::optional<uint32_t> item = deque.steal()) {
+          taken[*item].fetch_add(1);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < kCount; ++i) {
+    deque.push(i);
+    if (i % 3 == 0) {
+      if (std::optional<uint32_t> item = deque.pop()) {
+        taken[*item].fetch_add(1);
+      }
+    }
+  }
+  while (std::optional<uint32_t> item = deque.pop()) {
+    taken[*item].fetch_add(1);
+  }
+  done = true;
+  for (std::thread& thief : thieves) {
+    thief.join();
+  }
+  for (std::atomic<int>& times : taken) {
+    ASSERT_EQ(times.load(), 1);
+  }
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+#include "deque.hpp"
+
+const size_t kDefaultStealingSize = 64;
+
+// Chase-Lev deque: one owner thread pushes and pops at the bottom, any
+// number of thieves steal from the top. Owner operations take no locks and
+// only contend with a thief for the last element, which both claim by a
+// CAS on top_. Follows Le et al., "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (2013), with the fences folded into seq_cst accesses.
+//
+// Thieves read a slot before they know whether they won it, so slots are
+// atomics and T must be trivially copyable, e.g. a task pointer or index.
+// When the owner outgrows the ring it copies it into one twice the size;
+// a thief may still be reading the old ring, so it is kept until the deque
+// is destroyed.
+template <typename T, typename Alloc = std::allocator<T>>
+class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "T must be trivially copyable");
+
+ public:
+  WorkStealingDeque(size_t capacity = kDefaultStealingSize,
+                    const Alloc& alloc = Alloc());
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  ~WorkStealingDeque();
+
+  // Owner only.
+  void push(T value);
+  std::optional<T> pop();
+
+  // Any thread. Returns nothing if the deque is empty or another thread
+  // took the top element first.
+  std::optional<T> steal();
+
+  size_t size() const {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? bottom - top : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+ private:
+  struct Ring {
+    size_t mask;
+    Ring* retired;
+    std::atomic<T>* slots;
+
+    T get(int64_t index) const {
+      return slots[index & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t index, T value) {
+      slots[index & mask].store(value, std::memory_order_relaxed);
+    }
+  };
+
+  using alloc_traits = std::allocator_traits<Alloc>;
+  using slot_alloc =
+      typename alloc_traits::template rebind_alloc<std::atomic<T>>;
+  using slot_traits = std::allocator_traits<slot_alloc>;
+  using ring_alloc = typename alloc_traits::template rebind_alloc<Ring>;
+  using ring_traits = std::allocator_traits<ring_alloc>;
+
+  alignas(kCacheLine) std::atomic<int64_t> top_{0};
+  alignas(kCacheLine) std::atomic<int64_t> bottom_{0};
+  alignas(kCacheLine) std::atomic<Ring*> ring_;
+  Alloc alloc_;
+
+  // Copies [top, bottom) into a ring twice the size and publishes it.
+  Ring* grow(Ring* ring, int64_t top, int64_t bottom);
+
+  Ring* allocate_ring(size_t size, Ring* retired);
+  void deallocate_ring(Ring* ring);
+};
+
+template <typename T, typename Alloc>
+WorkStealingDeque<T, Alloc>::WorkStealingDeque(size_t capacity,
+                                               const Alloc& alloc)
+    : alloc_(alloc) {
+  ring_.store(allocate_ring(std::bit_ceil(capacity), nullptr),
+              std::memory_order_relaxed);
+}
+
+template <typename T, typename Alloc>
+WorkStealingDeque<T, Alloc>::~WorkStealingDeque() {
+  Ring* ring = ring_.load(std::memory_order_relaxed);
+  while (ring != nullptr) {
+    Ring* retired = ring->retired;
+    deallocate_ring(ring);
+    ring = retired;
+  }
+}
+
+template <typename T, typename Alloc>
+void WorkStealingDeque<T, Alloc>::push(T value) {
+  int64_t bottom = bottom_.load(std::memory_order_relaxed);
+  int64_t top = top_.load(std::memory_order_acquire);
+  Ring* ring = ring_.load(std::memory_order_relaxed);
+  if (bottom - top > static_cast<int64_t>(ring->mask)) {
+    ring = grow(ring, top, bottom);
+  }
+  ring->put(bottom, value);
+  bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+// Reserving the bottom element before reading top_ makes a thief that
+// reads top_ afterwards see the smaller bottom_; for the last element
+// both sides then race on top_.
+template <typename T, typename Alloc>
+std::optional<T> WorkStealingDeque<T, Alloc>::pop() {
+  int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  Ring* ring = ring_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_seq_cst);
+  int64_t top = top_.load(std::memory_order_seq_cst);
+  if (top > bottom) {
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+  T value = ring->get(bottom);
+  if (top == bottom) {
+    bool won = top_.compare_exchange_strong(top, top + 1,
+                                            std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    if (!won) {
+      return std::nullopt;
+    }
+  }
+  return value;
+}
+
+template <typename T, typename Alloc>
+std::optional<T> WorkStealingDeque<T, Alloc>::steal() {
+  int64_t top = top_.load(std::memory_order_seq_cst);
+  int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+  if (top >= bottom) {
+    return std::nullopt;
+  }
+  T value = ring_.load(std::memory_order_acquire)->get(top);
+  if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+template <typename T, typename Alloc>
+typename WorkStealingDeque<T, Alloc>::Ring*
+WorkStealingDeque<T, Alloc>::grow(Ring* ring, int64_t top, int64_t bottom) {
+  Ring* bigger = allocate_ring(2 * (ring->mask + 1), ring);
+  for (int64_t index = top; index < bottom; ++index) {
+    bigger->put(index, ring->get(index));
+  }
+  ring_.store(bigger, std::memory_order_release);
+  return bigger;
+}
+
+template <typename T, typename Alloc>
+typename WorkStealingDeque<T, Alloc>::Ring*
+WorkStealingDeque<T, Alloc>::allocate_ring(size_t size, Ring* retired) {
+  slot_alloc alloc(alloc_);
+  ring_alloc rings(alloc_);
+  std::atomic<T>* slots = slot_traits::allocate(alloc, size);
+  Ring* ring;
+  try {
+    ring = ring_traits::allocate(rings, 1);
+  } catch (...) {
+    slot_traits::deallocate(alloc, slots, size);
+    throw;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    ::new (static_cast<void*>(slots + i)) std::atomic<T>();
+  }
+  return ::new (static_cast<void*>(ring)) Ring{size - 1, retired, slots};
+}
+
+template <typename T, typename Alloc>
+void WorkStealingDeque<T, Alloc>::deallocate_ring(Ring* ring) {
+  slot_alloc alloc(alloc_);
+  ring_alloc rings(alloc_);
+  slot_traits::deallocate(alloc, ring->slots, ring->mask + 1);
+  ring_traits::deallocate(rings, ring, 1);
+}
@@ -0,0 +1,112 @@
+#include "mapped_string.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+MappedString::MappedString(const char* path) : str_(nullptr), size_(0) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1) {
+    int error = errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ > 0) {
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      int error = errno;
+      close(fd);
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    str_ = static_cast<const char*>(addr);
+  }
+  close(fd);
+}
+
+MappedString::MappedString(MappedString&& other) noexcept
+    : str_(other.str_), size_(other.size_) {
+  other.str_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedString& MappedString::operator=(MappedString&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    str_ = other.str_;
+    size_ = other.size_;
+    other.str_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+MappedString::~MappedString() { Unmap(); }
+
+void MappedString::Unmap() {
+  if (str_ != nullptr) {
+    munmap(const_cast<char*>(str_), size_);
+  }
+}
+
+const char& MappedString::operator[](size_t i) const { return str_[i]; }
+
+const char& MappedString::Front() const { return str_[0]; }
+
+const char& MappedString::Back() const { return str_[size_ - 1]; }
+
+bool MappedString::Empty() const { return size_ == 0; }
+
+size_t MappedString::Size() const { return size_; }
+
+const char* MappedString::Data() const { return str_; }
+
+StringView MappedString::View() const { return StringView(str_, size_); }
+
+MappedString::operator StringView() const { return View(); }
+
+size_t MappedString::Find(StringView needle, size_t pos) const {
+  return View().Find(needle, pos);
+}
+
+size_t MappedString::Find(char character, size_t pos) const {
+  return View().Find(character, pos);
+}
+
+size_t MappedString::RFind(StringView needle, size_t pos) const {
+  return View().RFind(needle, pos);
+}
+
+size_t MappedString::RFind(char character, size_t pos) const {
+  return View().RFind(character, pos);
+}
+
+size_t MappedString::FindFirstOf(StringView chars, size_t pos) const {
+  return View().FindFirstOf(chars, pos);
+}
+
+size_t MappedString::Count(StringView needle) const {
+  return View().Count(needle);
+}
+
+std::vector<StringView> MappedString::Split(StringView delim) const {
+  return View().Split(delim);
+}
+
+std::vector<StringView> MappedString::ParallelSplit(StringView delim,
+                                                    size_t threads) const {
+  return View().ParallelSplit(delim, threads);
+}
+
+std::ostream& operator<<(std::ostream& os, const MappedString& other) {
+  return os.write(other.str_, other.size_);
+}
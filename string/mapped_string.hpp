@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+
+#include "string.hpp"
+
+class MappedString {
+ public:
+  explicit MappedString(const char* path);
+
+  MappedString(const MappedString&) = delete;
+
+  MappedString& operator=(const MappedString&) = delete;
+
+  MappedString(MappedString&&) noexcept;
+
+  MappedString& operator=(MappedString&&) noexcept;
+
+  ~MappedString();
+
+  const char& operator[](size_t i) const;
+
+  const char& Front() const;
+
+  const char& Back() const;
+
+  bool Empty() const;
+
+  size_t Size() const;
+
+  const char* Data() const;
+
+  StringView View() const;
+
+  operator StringView() const;
+
+  size_t Find(StringView, size_t pos = 0) const;
+
+  size_t Find(char, size_t pos = 0) const;
+
+  size_t RFind(StringView, size_t pos = kNpos) const;
+
+  size_t RFind(char, size_t pos = kNpos) const;
+
+  size_t FindFirstOf(StringView, size_t pos = 0) const;
+
+  size_t Count(StringView) const;
+
+  std::vector<StringView> Split(StringView delim = " ") const;
+
+  std::vector<StringView> ParallelSplit(StringView delim,
+                                        size_t threads = 0) const;
+
+  friend std::ostream& operator<<(std::ostream&, const MappedString&);
+
+ private:
+  const char* str_;
+  size_t size_;
+
+  void Unmap();
+};
@@ -0,0 +1,229 @@
+#include "rope.hpp"
+
+#include <algorithm>
+
+struct Rope::Node {
+  NodePtr left;
+  NodePtr right;
+  std::shared_ptr<const String> chunk;
+  size_t offset = 0;
+  size_t size = 0;
+  size_t height = 0;
+
+  bool IsLeaf() const { return chunk != nullptr; }
+
+  static size_t HeightOf(const NodePtr& node) {
+    return node ? node->height : 0;
+  }
+
+  static size_t SizeOf(const NodePtr& node) { return node ? node->size : 0; }
+};
+
+Rope::Rope() = default;
+
+Rope::Rope(const String& s)
+    : Rope(s.Empty() ? nullptr
+                     : MakeLeaf(std::make_shared<const String>(s), 0,
+                                s.Size())) {}
+
+Rope::Rope(String&& s) {
+  size_t size = s.Size();
+  if (size > 0) {
+    root_ = MakeLeaf(std::make_shared<const String>(std::move(s)), 0, size);
+  }
+}
+
+Rope::Rope(StringView s) : Rope(String(s.Data(), s.Size())) {}
+
+Rope::Rope(const char* s) : Rope(StringView(s)) {}
+
+Rope::Rope(NodePtr root) : root_(std::move(root)) {}
+
+size_t Rope::Size() const { return Node::SizeOf(root_); }
+
+bool Rope::Empty() const { return root_ == nullptr; }
+
+char Rope::operator[](size_t i) const {
+  const Node* node = root_.get();
+  while (!node->IsLeaf()) {
+    if (i < node->left->size) {
+      node = node->left.get();
+    } else {
+      i -= node->left->size;
+      node = node->right.get();
+    }
+  }
+  return (*node->chunk)[node->offset + i];
+}
+
+Rope& Rope::operator+=(const Rope& other) {
+  root_ = Join(root_, other.root_);
+  return *this;
+}
+
+Rope operator+(const Rope& first, const Rope& second) {
+  return Rope(Rope::Join(first.root_, second.root_));
+}
+
+Rope Rope::Substr(size_t pos, size_t len) const {
+  size_t size = Size();
+  if (pos > size) {
+    pos = size;
+  }
+  if (len > size - pos) {
+    len = size - pos;
+  }
+  NodePtr rest = Split(root_, pos).second;
+  return Rope(Split(rest, len).first);
+}
+
+void Rope::Insert(size_t pos, const Rope& other) {
+  auto parts = Split(root_, pos);
+  root_ = Join(Join(parts.first, other.root_), parts.second);
+}
+
+void Rope::Erase(size_t pos, size_t len) {
+  auto parts = Split(root_, pos);
+  root_ = Join(parts.first, Split(parts.second, len).second);
+}
+
+String Rope::Flatten(std::pmr::memory_resource* resource) const {
+  String res(Size(), resource);
+  char* dst = res.Data();
+  for (auto it = ChunkBegin(); it != ChunkEnd(); ++it) {
+    memcpy(dst, it->Data(), it->Size());
+    dst += it->Size();
+  }
+  return res;
+}
+
+Rope::ChunkIterator Rope::ChunkBegin() const {
+  return ChunkIterator(root_.get());
+}
+
+Rope::ChunkIterator Rope::ChunkEnd() const { return ChunkIterator(); }
+
+std::ostream& operator<<(std::ostream& os, const Rope& rope) {
+  for (auto it = rope.ChunkBegin(); it != rope.ChunkEnd(); ++it) {
+    os.write(it->Data(), it->Size());
+  }
+  return os;
+}
+
+Rope::NodePtr Rope::MakeLeaf(std::shared_ptr<const String> chunk,
+                             size_t offset, size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+  auto node = std::make_shared<Node>();
+  node->chunk = std::move(chunk);
+  node->offset = offset;
+  node->size = size;
+  node->height = 1;
+  return node;
+}
+
+Rope::NodePtr Rope::MakeNode(NodePtr left, NodePtr right) {
+  auto node = std::make_shared<Node>();
+  node->size = left->size + right->size;
+  node->height = 1 + std::max(left->height, right->height);
+  node->left = std::move(left);
+  node->right = std::move(right);
+  return node;
+}
+
+// Children may differ in height by at most two; one single or double AVL
+// rotation restores the invariant.
+Rope::NodePtr Rope::Balance(NodePtr left, NodePtr right) {
+  if (left->height > right->height + 1) {
+    if (Node::HeightOf(left->left) >= Node::HeightOf(left->right)) {
+      return MakeNode(left->left, MakeNode(left->right, std::move(right)));
+    }
+    const NodePtr& mid = left->right;
+    return MakeNode(MakeNode(left->left, mid->left),
+                    MakeNode(mid->right, std::move(right)));
+  }
+  if (right->height > left->height + 1) {
+    if (Node::HeightOf(right->right) >= Node::HeightOf(right->left)) {
+      return MakeNode(MakeNode(std::move(left), right->left), right->right);
+    }
+    const NodePtr& mid = right->left;
+    return MakeNode(MakeNode(std::move(left), mid->left),
+                    MakeNode(mid->right, right->right));
+  }
+  return MakeNode(std::move(left), std::move(right));
+}
+
+Rope::NodePtr Rope::Join(const NodePtr& left, const NodePtr& right) {
+  if (!left) {
+    return right;
+  }
+  if (!right) {
+    return left;
+  }
+  if (left->IsLeaf() && right->IsLeaf() &&
+      left->size + right->size <= kRopeLeafMerge) {
+    String merged(left->size + right->size);
+    memcpy(merged.Data(), left->chunk->Data() + left->offset, left->size);
+    memcpy(merged.Data() + left->size, right->chunk->Data() + right->offset,
+           right->size);
+    size_t size = merged.Size();
+    return MakeLeaf(std::make_shared<const String>(std::move(merged)), 0,
+                    size);
+  }
+  if (left->height > right->height + 1) {
+    return Balance(left->left, Join(left->right, right));
+  }
+  if (right->height > left->height + 1) {
+    return Balance(Join(left, right->left), right->right);
+  }
+  return MakeNode(left, right);
+}
+
+std::pair<Rope::NodePtr, Rope::NodePtr> Rope::Split(const NodePtr& node,
+                                                    size_t pos) {
+  if (!node || pos == 0) {
+    return {nullptr, node};
+  }
+  if (pos >= node->size) {
+    return {node, nullptr};
+  }
+  if (node->IsLeaf()) {
+    return {MakeLeaf(node->chunk, node->offset, pos),
+            MakeLeaf(node->chunk, node->offset + pos, node->size - pos)};
+  }
+  size_t left_size = node->left->size;
+  if (pos <= left_size) {
+    auto parts = Split(node->left, pos);
+    return {parts.first, Join(parts.second, node->right)};
+  }
+  auto parts = Split(node->right, pos - left_size);
+  return {Join(node->left, parts.first), parts.second};
+}
+
+Rope::ChunkIterator::ChunkIterator(const Node* root) {
+  if (root != nullptr) {
+    Descend(root);
+  }
+}
+
+void Rope::ChunkIterator::Descend(const Node* node) {
+  while (!node->IsLeaf()) {
+    path_.push_back(node->right.get());
+    node = node->left.get();
+  }
+  path_.push_back(node);
+  chunk_ = StringView(node->chunk->Data() + node->offset, node->size);
+}
+
+Rope::ChunkIterator& Rope::ChunkIterator::operator++() {
+  path_.pop_back();
+  if (path_.empty()) {
+    chunk_ = StringView();
+    return *this;
+  }
+  const Node* next = path_.back();
+  path_.pop_back();
+  Descend(next);
+  return *this;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "string.hpp"
+
+const size_t kRopeLeafMerge = 256;
+
+class Rope {
+ public:
+  class ChunkIterator;
+
+  Rope();
+
+  Rope(const String&);
+
+  Rope(String&&);
+
+  Rope(StringView);
+
+  Rope(const char*);
+
+  size_t Size() const;
+
+  bool Empty() const;
+
+  char operator[](size_t) const;
+
+  Rope& operator+=(const Rope&);
+
+  friend Rope operator+(const Rope&, const Rope&);
+
+  Rope Substr(size_t pos, size_t len = kNpos) const;
+
+  void Insert(size_t pos, const Rope&);
+
+  void Erase(size_t pos, size_t len = kNpos);
+
+  String Flatten(
+      std::pmr::memory_resource* = std::pmr::get_default_resource()) const;
+
+  ChunkIterator ChunkBegin() const;
+
+  ChunkIterator ChunkEnd() const;
+
+  friend std::ostream& operator<<(std::ostream&, const Rope&);
+
+ private:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+  explicit Rope(NodePtr);
+
+  static NodePtr MakeLeaf(std::shared_ptr<const String>, size_t, size_t);
+
+  static NodePtr MakeNode(NodePtr, NodePtr);
+
+  static NodePtr Balance(NodePtr, NodePtr);
+
+  static NodePtr Join(const NodePtr&, const NodePtr&);
+
+  static std::pair<NodePtr, NodePtr> Split(const NodePtr&, size_t);
+
+  NodePtr root_;
+};
+
+class Rope::ChunkIterator {
+ public:
+  using value_type = StringView;
+  using pointer = const StringView*;
+  using reference = const StringView&;
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+
+  ChunkIterator() = default;
+
+  reference operator*() const { return chunk_; }
+
+  pointer operator->() const { return &chunk_; }
+
+  ChunkIterator& operator++();
+
+  ChunkIterator operator++(int) {
+    ChunkIterator copy(*this);
+    ++*this;
+    return copy;
+  }
+
+  friend bool operator==(const ChunkIterator& first,
+                         const ChunkIterator& second) {
+    return first.path_ == second.path_;
+  }
+
+  friend bool operator!=(const ChunkIterator& first,
+                         const ChunkIterator& second) {
+    return !(first == second);
+  }
+
+ private:
+  friend class Rope;
+
+  explicit ChunkIterator(const Node*);
+
+  void Descend(const Node*);
+
+  std::vector<const Node*> path_;
+  StringView chunk_;
+};
@@ -0,0 +1,102 @@
+#include "shared_string.hpp"
+
+#include <new>
+#include <utility>
+
+SharedString::SharedString() : header_(nullptr) {}
+
+SharedString::SharedString(StringView s) : header_(nullptr) {
+  if (s.Empty()) {
+    return;
+  }
+  void* block = ::operator new(sizeof(Header) + s.Size() + 1);
+  header_ = new (block) Header{{1}, s.Size()};
+  memcpy(Chars(), s.Data(), s.Size());
+  Chars()[s.Size()] = '\0';
+}
+
+SharedString::SharedString(const char* s) : SharedString(StringView(s)) {}
+
+SharedString::SharedString(const String& s) : SharedString(StringView(s)) {}
+
+SharedString::SharedString(const SharedString& other) noexcept
+    : header_(other.header_) {
+  if (header_ != nullptr) {
+    header_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+SharedString::SharedString(SharedString&& other) noexcept
+    : header_(other.header_) {
+  other.header_ = nullptr;
+}
+
+SharedString& SharedString::operator=(const SharedString& other) noexcept {
+  SharedString copy(other);
+  std::swap(header_, copy.header_);
+  return *this;
+}
+
+SharedString& SharedString::operator=(SharedString&& other) noexcept {
+  std::swap(header_, other.header_);
+  return *this;
+}
+
+SharedString::~SharedString() { Release(); }
+
+void SharedString::Release() {
+  if (header_ != nullptr &&
+      header_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    header_->~Header();
+    ::operator delete(header_);
+  }
+}
+
+char* SharedString::Chars() const {
+  return reinterpret_cast<char*>(header_ + 1);
+}
+
+const char& SharedString::operator[](size_t i) const { return Chars()[i]; }
+
+const char& SharedString::Front() const { return Chars()[0]; }
+
+const char& SharedString::Back() const { return Chars()[header_->size - 1]; }
+
+bool SharedString::Empty() const { return header_ == nullptr; }
+
+size_t SharedString::Size() const {
+  return header_ == nullptr ? 0 : header_->size;
+}
+
+const char* SharedString::Data() const {
+  return header_ == nullptr ? "" : Chars();
+}
+
+size_t SharedString::UseCount() const {
+  return header_ == nullptr ? 0
+                            : header_->refs.load(std::memory_order_relaxed);
+}
+
+StringView SharedString::View() const { return StringView(Data(), Size()); }
+
+SharedString::operator StringView() const { return View(); }
+
+String SharedString::ToString(std::pmr::memory_resource* resource) const {
+  return String(Data(), Size(), resource);
+}
+
+bool operator==(const SharedString& first, const SharedString& second) {
+  if (first.header_ == second.header_) {
+    return true;
+  }
+  return first.Size() == second.Size() &&
+         memcmp(first.Data(), second.Data(), first.Size()) == 0;
+}
+
+bool operator!=(const SharedString& first, const SharedString& second) {
+  return !(first == second);
+}
+
+std::ostream& operator<<(std::ostream& os, const SharedString& other) {
+  return os.write(other.Data(), other.Size());
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <iostream>
+
+#include "string.hpp"
+
+class SharedString {
+ public:
+  SharedString();
+
+  SharedString(StringView);
+
+  SharedString(const char*);
+
+  explicit SharedString(const String&);
+
+  SharedString(const SharedString&) noexcept;
+
+  SharedString(SharedString&&) noexcept;
+
+  SharedString& operator=(const SharedString&) noexcept;
+
+  SharedString& operator=(SharedString&&) noexcept;
+
+  ~SharedString();
+
+  const char& operator[](size_t i) const;
+
+  const char& Front() const;
+
+  const char& Back() const;
+
+  bool Empty() const;
+
+  size_t Size() const;
+
+  const char* Data() const;
+
+  size_t UseCount() const;
+
+  StringView View() const;
+
+  operator StringView() const;
+
+  String ToString(
+      std::pmr::memory_resource* = std::pmr::get_default_resource()) const;
+
+  friend bool operator==(const SharedString&, const SharedString&);
+
+  friend bool operator!=(const SharedString&, const SharedString&);
+
+  friend std::ostream& operator<<(std::ostream&, const SharedString&);
+
+ private:
+  struct Header {
+    std::atomic<size_t> refs;
+    size_t size;
+  };
+
+  Header* header_;
+
+  char* Chars() const;
+
+  void Release();
+};
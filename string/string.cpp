@@ -1,53 +1,581 @@
 #include "string.hpp"
 
-String::String() {
-  size_ = 0;
-  capacity_ = 0;
-  str_ = nullptr;
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <charconv>
+#include <cstdint>
+#include <locale>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+// Needles up to this length are searched with the first/last byte filter,
+// longer ones with Boyer-Moore-Horspool.
+const size_t kShortNeedle = 32;
+const size_t kSmallSet = 4;
+const size_t kAlphabet = 256;
+const size_t kMinSplitChunk = 1 << 20;
+
+#if defined(__AVX2__)
+const size_t kLanes = 32;
+
+uint32_t EqualMask(const char* p, char c) {
+  __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  __m256i eq = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
 }
 
-String::String(size_t size) : size_(size), capacity_(size) {
-  str_ = new char[size + 1];
+// 'A'..'Z' are the only bytes that land below -102 after adding 128 - 'A'.
+void LowerBlock(char* p) {
+  __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  __m256i shifted = _mm256_add_epi8(block, _mm256_set1_epi8(128 - 'A'));
+  __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  block = _mm256_add_epi8(block, _mm256_and_si256(upper, _mm256_set1_epi8(32)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), block);
+}
+#elif defined(__SSE2__)
+const size_t kLanes = 16;
+
+uint32_t EqualMask(const char* p, char c) {
+  __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i eq = _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+  return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+}
+
+// 'A'..'Z' are the only bytes that land below -102 after adding 128 - 'A'.
+void LowerBlock(char* p) {
+  __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i shifted = _mm_add_epi8(block, _mm_set1_epi8(128 - 'A'));
+  __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+  block = _mm_add_epi8(block, _mm_and_si128(upper, _mm_set1_epi8(32)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), block);
+}
+#else
+const size_t kLanes = 8;
+
+uint32_t EqualMask(const char* p, char c) {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kLanes; ++i) {
+    mask |= static_cast<uint32_t>(p[i] == c) << i;
+  }
+  return mask;
+}
+
+void LowerBlock(char* p) {
+  for (size_t i = 0; i < kLanes; ++i) {
+    if (p[i] >= 'A' && p[i] <= 'Z') {
+      p[i] += 'a' - 'A';
+    }
+  }
+}
+#endif
+
+bool IsAsciiSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+int LowestBit(uint32_t mask) { return __builtin_ctz(mask); }
+
+int HighestBit(uint32_t mask) { return 31 - __builtin_clz(mask); }
+
+bool MatchAt(const char* hay, const char* needle, size_t m) {
+  return memcmp(hay, needle, m) == 0;
+}
+
+size_t ForwardShort(const char* hay, size_t n, const char* needle, size_t m) {
+  size_t i = 0;
+  for (; i + m - 1 + kLanes <= n; i += kLanes) {
+    uint32_t mask =
+        EqualMask(hay + i, needle[0]) & EqualMask(hay + i + m - 1, needle[m - 1]);
+    while (mask != 0) {
+      size_t cand = i + LowestBit(mask);
+      if (MatchAt(hay + cand + 1, needle + 1, m - 2)) {
+        return cand;
+      }
+      mask &= mask - 1;
+    }
+  }
+  for (; i + m <= n; ++i) {
+    if (hay[i] == needle[0] && MatchAt(hay + i + 1, needle + 1, m - 1)) {
+      return i;
+    }
+  }
+  return kNpos;
+}
+
+size_t ForwardLong(const char* hay, size_t n, const char* needle, size_t m) {
+  size_t shift[kAlphabet];
+  for (size_t c = 0; c < kAlphabet; ++c) {
+    shift[c] = m;
+  }
+  for (size_t k = 0; k + 1 < m; ++k) {
+    shift[static_cast<unsigned char>(needle[k])] = m - 1 - k;
+  }
+  for (size_t i = 0; i + m <= n;) {
+    char last = hay[i + m - 1];
+    if (last == needle[m - 1] && MatchAt(hay + i, needle, m - 1)) {
+      return i;
+    }
+    i += shift[static_cast<unsigned char>(last)];
+  }
+  return kNpos;
+}
+
+// Candidate positions are [0, hi), scanned from the right.
+size_t BackwardShort(const char* hay, size_t hi, const char* needle, size_t m) {
+  while (hi >= kLanes) {
+    size_t j = hi - kLanes;
+    uint32_t mask =
+        EqualMask(hay + j, needle[0]) & EqualMask(hay + j + m - 1, needle[m - 1]);
+    while (mask != 0) {
+      int bit = HighestBit(mask);
+      if (m == 1 || MatchAt(hay + j + bit + 1, needle + 1, m - 2)) {
+        return j + bit;
+      }
+      mask &= ~(static_cast<uint32_t>(1) << bit);
+    }
+    hi = j;
+  }
+  while (hi > 0) {
+    --hi;
+    if (hay[hi] == needle[0] && MatchAt(hay + hi + 1, needle + 1, m - 1)) {
+      return hi;
+    }
+  }
+  return kNpos;
+}
+
+size_t BackwardLong(const char* hay, size_t hi, const char* needle, size_t m) {
+  size_t shift[kAlphabet];
+  for (size_t c = 0; c < kAlphabet; ++c) {
+    shift[c] = m;
+  }
+  for (size_t k = m - 1; k > 0; --k) {
+    shift[static_cast<unsigned char>(needle[k])] = k;
+  }
+  size_t i = hi - 1;
+  while (true) {
+    char first = hay[i];
+    if (first == needle[0] && MatchAt(hay + i + 1, needle + 1, m - 1)) {
+      return i;
+    }
+    size_t step = shift[static_cast<unsigned char>(first)];
+    if (i < step) {
+      return kNpos;
+    }
+    i -= step;
+  }
+}
+
+size_t SearchForward(const char* hay, size_t n, const char* needle, size_t m,
+                     size_t pos) {
+  if (pos > n || m > n - pos) {
+    return kNpos;
+  }
+  if (m == 0) {
+    return pos;
+  }
+  if (m == 1) {
+    const void* found = memchr(hay + pos, needle[0], n - pos);
+    return found == nullptr ? kNpos : static_cast<const char*>(found) - hay;
+  }
+  hay += pos;
+  n -= pos;
+  size_t res;
+  if (m <= kShortNeedle) {
+    res = ForwardShort(hay, n, needle, m);
+  } else {
+    res = ForwardLong(hay, n, needle, m);
+  }
+  return res == kNpos ? kNpos : res + pos;
+}
+
+size_t SearchBackward(const char* hay, size_t n, const char* needle, size_t m,
+                      size_t pos) {
+  if (m > n) {
+    return kNpos;
+  }
+  size_t last = n - m < pos ? n - m : pos;
+  if (m == 0) {
+    return last;
+  }
+  if (m <= kShortNeedle) {
+    return BackwardShort(hay, last + 1, needle, m);
+  }
+  return BackwardLong(hay, last + 1, needle, m);
+}
+
+size_t SearchAnyOf(const char* hay, size_t n, const char* set, size_t k,
+                   size_t pos) {
+  if (pos >= n || k == 0) {
+    return kNpos;
+  }
+  if (k == 1) {
+    const void* found = memchr(hay + pos, set[0], n - pos);
+    return found == nullptr ? kNpos : static_cast<const char*>(found) - hay;
+  }
+  size_t i = pos;
+  if (k <= kSmallSet) {
+    for (; i + kLanes <= n; i += kLanes) {
+      uint32_t mask = 0;
+      for (size_t j = 0; j < k; ++j) {
+        mask |= EqualMask(hay + i, set[j]);
+      }
+      if (mask != 0) {
+        return i + LowestBit(mask);
+      }
+    }
+  }
+  bool in_set[kAlphabet] = {};
+  for (size_t j = 0; j < k; ++j) {
+    in_set[static_cast<unsigned char>(set[j])] = true;
+  }
+  for (; i < n; ++i) {
+    if (in_set[static_cast<unsigned char>(hay[i])]) {
+      return i;
+    }
+  }
+  return kNpos;
+}
+
+// wyhash (final version): 64-bit multiply-mix over 16/48-byte stripes.
+const uint64_t kWySecret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                               0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+void WyMum(uint64_t* a, uint64_t* b) {
+  __uint128_t r = static_cast<__uint128_t>(*a) * *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64);
+}
+
+uint64_t WyMix(uint64_t a, uint64_t b) {
+  WyMum(&a, &b);
+  return a ^ b;
+}
+
+uint64_t WyRead8(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t WyRead4(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t WyRead3(const char* p, size_t k) {
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  return (static_cast<uint64_t>(u[0]) << 16) |
+         (static_cast<uint64_t>(u[k >> 1]) << 8) | u[k - 1];
+}
+
+uint64_t WyHash(const char* p, size_t len) {
+  uint64_t seed = WyMix(kWySecret[0], kWySecret[1]);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (len <= 16) {
+    if (len >= 4) {
+      size_t shift = (len >> 3) << 2;
+      a = (WyRead4(p) << 32) | WyRead4(p + shift);
+      b = (WyRead4(p + len - 4) << 32) | WyRead4(p + len - 4 - shift);
+    } else if (len > 0) {
+      a = WyRead3(p, len);
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = WyMix(WyRead8(p) ^ kWySecret[1], WyRead8(p + 8) ^ seed);
+        see1 = WyMix(WyRead8(p + 16) ^ kWySecret[2], WyRead8(p + 24) ^ see1);
+        see2 = WyMix(WyRead8(p + 32) ^ kWySecret[3], WyRead8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = WyMix(WyRead8(p) ^ kWySecret[1], WyRead8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = WyRead8(p + i - 16);
+    b = WyRead8(p + i - 8);
+  }
+  a ^= kWySecret[1];
+  b ^= seed;
+  WyMum(&a, &b);
+  return WyMix(a ^ kWySecret[0] ^ len, b ^ kWySecret[1]);
+}
+
+}  // namespace
+
+StringView::StringView() : str_(nullptr), size_(0) {}
+
+StringView::StringView(const char* s, size_t size) : str_(s), size_(size) {}
+
+StringView::StringView(const char* s) : str_(s), size_(strlen(s)) {}
+
+StringView::StringView(const String& s) : str_(s.Data()), size_(s.Size()) {}
+
+const char& StringView::operator[](size_t i) const { return str_[i]; }
+
+bool StringView::Empty() const { return size_ == 0; }
+
+size_t StringView::Size() const { return size_; }
+
+const char* StringView::Data() const { return str_; }
+
+int StringView::Compare(StringView other) const {
+  size_t common = size_ < other.size_ ? size_ : other.size_;
+  int res = common == 0 ? 0 : memcmp(str_, other.str_, common);
+  if (res != 0) {
+    return res;
+  }
+  if (size_ == other.size_) {
+    return 0;
+  }
+  return size_ < other.size_ ? -1 : 1;
+}
+
+size_t StringView::Hash() const { return WyHash(str_, size_); }
+
+StringView StringView::TrimLeft() const {
+  size_t begin = 0;
+  while (begin < size_ && IsAsciiSpace(str_[begin])) {
+    ++begin;
+  }
+  return StringView(str_ + begin, size_ - begin);
+}
+
+StringView StringView::TrimRight() const {
+  size_t end = size_;
+  while (end > 0 && IsAsciiSpace(str_[end - 1])) {
+    --end;
+  }
+  return StringView(str_, end);
+}
+
+StringView StringView::Trim() const { return TrimLeft().TrimRight(); }
+
+std::optional<int64_t> StringView::ParseInt(int base) const {
+  int64_t value = 0;
+  auto [end, error] = std::from_chars(str_, str_ + size_, value, base);
+  if (error != std::errc() || end != str_ + size_ || size_ == 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<double> StringView::ParseDouble() const {
+  double value = 0;
+  auto [end, error] = std::from_chars(str_, str_ + size_, value);
+  if (error != std::errc() || end != str_ + size_ || size_ == 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+StringView StringView::Substr(size_t pos, size_t len) const {
+  if (pos > size_) {
+    pos = size_;
+  }
+  if (len > size_ - pos) {
+    len = size_ - pos;
+  }
+  return StringView(str_ + pos, len);
+}
+
+size_t StringView::Find(StringView needle, size_t pos) const {
+  return SearchForward(str_, size_, needle.str_, needle.size_, pos);
+}
+
+size_t StringView::Find(char character, size_t pos) const {
+  return SearchForward(str_, size_, &character, 1, pos);
+}
+
+size_t StringView::RFind(StringView needle, size_t pos) const {
+  return SearchBackward(str_, size_, needle.str_, needle.size_, pos);
+}
+
+size_t StringView::RFind(char character, size_t pos) const {
+  return SearchBackward(str_, size_, &character, 1, pos);
+}
+
+size_t StringView::FindFirstOf(StringView chars, size_t pos) const {
+  return SearchAnyOf(str_, size_, chars.str_, chars.size_, pos);
+}
+
+size_t StringView::Count(StringView needle) const {
+  if (needle.Empty()) {
+    return size_ + 1;
+  }
+  size_t count = 0;
+  size_t pos = Find(needle);
+  while (pos != kNpos) {
+    ++count;
+    pos = Find(needle, pos + needle.size_);
+  }
+  return count;
+}
+
+std::vector<StringView> StringView::Split(StringView delim) const {
+  std::vector<StringView> res;
+  if (delim.Empty()) {
+    res.push_back(*this);
+    return res;
+  }
+  size_t begin = 0;
+  size_t end = Find(delim);
+  while (end != kNpos) {
+    res.emplace_back(str_ + begin, end - begin);
+    begin = end + delim.size_;
+    end = Find(delim, begin);
+  }
+  res.emplace_back(str_ + begin, size_ - begin);
+  return res;
+}
+
+std::vector<StringView> StringView::ParallelSplit(StringView delim,
+                                                  size_t threads) const {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (threads > size_ / kMinSplitChunk) {
+    threads = size_ / kMinSplitChunk;
+  }
+  if (threads <= 1 || delim.Empty()) {
+    return Split(delim);
+  }
+  size_t m = delim.size_;
+  std::vector<size_t> bounds(threads + 1);
+  for (size_t i = 0; i < threads; ++i) {
+    bounds[i] = size_ / threads * i;
+  }
+  bounds[threads] = size_;
+
+  // Each worker reports delimiters starting inside its chunk; it reads up to
+  // m - 1 bytes past the chunk end to catch delimiters spanning the border.
+  std::vector<std::vector<size_t>> found(threads);
+  auto scan = [&](size_t i) {
+    size_t end = bounds[i + 1] + m - 1 < size_ ? bounds[i + 1] + m - 1 : size_;
+    StringView part(str_ + bounds[i], end - bounds[i]);
+    size_t pos = part.Find(delim);
+    while (pos != kNpos) {
+      found[i].push_back(bounds[i] + pos);
+      pos = part.Find(delim, pos + m);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back(scan, i);
+  }
+  scan(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  size_t total = 1;
+  for (const auto& chunk : found) {
+    total += chunk.size();
+  }
+  std::vector<StringView> res;
+  res.reserve(total);
+  size_t begin = 0;
+  for (size_t i = 0; i < threads; ++i) {
+    bool in_sync = true;
+    for (size_t pos : found[i]) {
+      if (pos < begin) {
+        in_sync = false;
+        break;
+      }
+      res.emplace_back(str_ + begin, pos - begin);
+      begin = pos + m;
+    }
+    // A self-overlapping delimiter that ended past the border shifts the
+    // greedy match sequence, so the chunk is rescanned from the fixed point.
+    if (!in_sync) {
+      size_t pos = Find(delim, begin);
+      while (pos != kNpos && pos < bounds[i + 1]) {
+        res.emplace_back(str_ + begin, pos - begin);
+        begin = pos + m;
+        pos = Find(delim, begin);
+      }
+    }
+  }
+  res.emplace_back(str_ + begin, size_ - begin);
+  return res;
+}
+
+String::String() : String(std::pmr::get_default_resource()) {}
+
+String::String(std::pmr::memory_resource* resource)
+    : str_(nullptr), size_(0), capacity_(0), resource_(resource) {}
+
+String::String(size_t size, std::pmr::memory_resource* resource)
+    : size_(size), capacity_(size), resource_(resource) {
+  str_ = Allocate(capacity_);
   str_[size] = '\0';
 }
 
-String::String(size_t size, char character) : size_(size), capacity_(size_) {
-  str_ = new char[size + 1];
+String::String(size_t size, char character,
+               std::pmr::memory_resource* resource)
+    : size_(size), capacity_(size_), resource_(resource) {
+  str_ = Allocate(capacity_);
   for (size_t i = 0; i < size; ++i) {
     str_[i] = character;
   }
   str_[size] = '\0';
 }
 
-String::String(const char* s) {
-  size_t lenght = strlen(s);
-  str_ = new char[lenght + 1];
-  size_ = lenght;
-  capacity_ = lenght;
-  for (size_t i = 0; i < lenght; ++i) {
-    str_[i] = s[i];
-  }
-  str_[size_] = '\0';
+String::String(const char* s, std::pmr::memory_resource* resource)
+    : String(s, strlen(s), resource) {}
+
+String::String(const char* s, size_t size, std::pmr::memory_resource* resource)
+    : size_(size), capacity_(size), resource_(resource) {
+  str_ = Allocate(capacity_);
+  CopyChars(str_, StringView(s, size));
+  str_[size] = '\0';
 }
 
-String::String(const String& other) {
-  size_ = other.Size();
-  capacity_ = size_;
-  str_ = new char[capacity_ + 1];
+String::String(const String& other)
+    : String(other, std::pmr::get_default_resource()) {}
 
-  for (size_t i = 0; i < size_; i++) {
-    str_[i] = other.str_[i];
-  }
-  str_[size_] = '\0';
+String::String(const String& other, std::pmr::memory_resource* resource)
+    : String(other.str_, other.size_, resource) {
+  ALLOC_STATS_COPY("String");
+}
+
+String::String(String&& other) noexcept
+    : str_(other.str_),
+      size_(other.size_),
+      capacity_(other.capacity_),
+      resource_(other.resource_) {
+  other.str_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
 }
 
 String& String::operator=(const String& s) {
-  String copy(s);
+  String copy(s, resource_);
   Swap(copy);
   return *this;
 }
 
+String& String::operator=(String&& s) {
+  if (resource_->is_equal(*s.resource_)) {
+    Swap(s);
+    return *this;
+  }
+  return *this = s;
+}
+
 void String::PushBack(const char& character) {
+  ALLOC_STATS_SCOPE("String", "PushBack");
   if (size_ == capacity_) {
     Reserve(2 * capacity_);
   }
@@ -62,13 +590,17 @@ void String::PopBack() {
 }
 
 void String::Resize(size_t new_size) {
+  ALLOC_STATS_SCOPE("String", "Resize");
   if (new_size > capacity_) {
-    char* temp_str = new char[new_size];
-    capacity_ = new_size;
+    if (str_ != nullptr) {
+      ALLOC_STATS_REALLOCATION("String");
+    }
+    char* temp_str = Allocate(new_size);
     for (size_t i = 0; i < size_; ++i) {
       temp_str[i] = str_[i];
     }
-    delete[] str_;
+    Deallocate();
+    capacity_ = new_size;
     size_ = new_size;
     str_ = temp_str;
   } else {
@@ -77,6 +609,7 @@ void String::Resize(size_t new_size) {
 }
 
 void String::Resize(size_t new_size, char character) {
+  ALLOC_STATS_SCOPE("String", "Resize");
   if (new_size < size_ || (new_size > size_ && new_size < capacity_)) {
     size_ = new_size;
   }
@@ -90,32 +623,67 @@ void String::Resize(size_t new_size, char character) {
 }
 
 void String::Reserve(size_t new_cap) {
+  ALLOC_STATS_SCOPE("String", "Reserve");
   if (str_ == nullptr || size_ == 0) {
     new_cap = kDefaultSize;
   }
   if (new_cap > capacity_) {
-    char* new_str = new char[new_cap];
+    if (str_ != nullptr) {
+      ALLOC_STATS_REALLOCATION("String");
+    }
+    char* new_str = Allocate(new_cap);
     for (size_t i = 0; i < size_; ++i) {
       new_str[i] = str_[i];
     }
-    delete[] str_;
+    Deallocate();
     str_ = new_str;
     capacity_ = new_cap;
   }
 }
 
 void String::ShrinkToFit() {
+  ALLOC_STATS_SCOPE("String", "ShrinkToFit");
   if (capacity_ > size_) {
+    ALLOC_STATS_REALLOCATION("String");
+    char* new_str = Allocate(size_);
+    CopyChars(new_str, *this);
+    Deallocate();
+    str_ = new_str;
     capacity_ = size_;
   }
 }
 
+std::pmr::memory_resource* String::Resource() const { return resource_; }
+
+char* String::Allocate(size_t capacity) {
+  ALLOC_STATS_ALLOCATION("String", capacity + 1);
+  return static_cast<char*>(resource_->allocate(capacity + 1, alignof(char)));
+}
+
+void String::Reallocate(size_t new_cap) {
+  if (str_ != nullptr) {
+    ALLOC_STATS_REALLOCATION("String");
+  }
+  char* new_str = Allocate(new_cap);
+  CopyChars(new_str, *this);
+  Deallocate();
+  str_ = new_str;
+  capacity_ = new_cap;
+}
+
+void String::Deallocate() {
+  if (str_ != nullptr) {
+    resource_->deallocate(str_, capacity_ + 1, alignof(char));
+  }
+}
+
 String& String::Swap(String& other) {
   char* temp = str_;
   this->str_ = other.str_;
   other.str_ = temp;
   std::swap(size_, other.size_);
   std::swap(capacity_, other.capacity_);
+  std::swap(resource_, other.resource_);
   return *this;
 }
 
@@ -141,13 +709,14 @@ char* String::Data() { return str_; }
 
 const char* String::Data() const { return str_; }
 
+int String::Compare(StringView other) const {
+  return StringView(*this).Compare(other);
+}
+
+size_t String::Hash() const { return StringView(*this).Hash(); }
+
 bool operator<(const String& first, const String& second) {
-  bool f = true;
-  int res = strcmp(first.str_, second.str_);
-  if (res >= 0) {
-    f = false;
-  }
-  return f;
+  return first.Compare(second) < 0;
 }
 
 bool operator>=(const String& first, const String& second) {
@@ -155,12 +724,7 @@ bool operator>=(const String& first, const String& second) {
 }
 
 bool operator>(const String& first, const String& second) {
-  bool f = true;
-  int res = strcmp(first.str_, second.str_);
-  if (res <= 0) {
-    f = false;
-  }
-  return f;
+  return first.Compare(second) > 0;
 }
 
 bool operator<=(const String& first, const String& second) {
@@ -168,92 +732,222 @@ bool operator<=(const String& first, const String& second) {
 }
 
 bool operator==(const String& first, const String& second) {
-  bool f = true;
-  for (size_t i = 0; i < second.Size(); ++i) {
-    if (first[i] != second[i]) {
-      f = false;
-      break;
-    }
+  if (first.size_ != second.size_) {
+    return false;
   }
-  return f;
+  return first.size_ == 0 || memcmp(first.str_, second.str_, first.size_) == 0;
 }
 
 bool operator!=(const String& first, const String& second) {
-  return first.str_ != second.str_;
+  return !(first == second);
 }
 
 String& String::operator+=(const String& other) {
-  size_t t = Size();
-  Resize(size_ + other.size_);
-  memcpy(Data() + t, other.Data(), other.Size());
-  capacity_ = size_;
+  ALLOC_STATS_SCOPE("String", "operator+=");
+  size_t added = other.size_;
+  if (size_ + added > capacity_) {
+    Reallocate(2 * capacity_ > size_ + added ? 2 * capacity_ : size_ + added);
+  }
+  CopyChars(str_ + size_, StringView(other.str_, added));
+  size_ += added;
   return *this;
 }
 
 String operator+(const String& first, const String& second) {
-  String temp = first;
+  ALLOC_STATS_SCOPE("String", "operator+");
+  String temp(first, first.resource_);
   temp += second;
   return temp;
 }
 
 String& String::operator*=(size_t n) {
-  size_t temp = Size();
-  Resize(Size() * n);
-  for (size_t i = 1; i < n; ++i) {
-    memcpy(Data() + i * temp, Data(), temp);
+  ALLOC_STATS_SCOPE("String", "operator*=");
+  size_t total = size_ * n;
+  if (total > capacity_) {
+    if (str_ != nullptr) {
+      ALLOC_STATS_REALLOCATION("String");
+    }
+    char* new_str = Allocate(total);
+    CopyChars(new_str, *this);
+    Deallocate();
+    str_ = new_str;
+    capacity_ = total;
+  }
+  size_t filled = size_;
+  size_ = total;
+  while (filled > 0 && filled < total) {
+    size_t step = filled < total - filled ? filled : total - filled;
+    memcpy(str_ + filled, str_, step);
+    filled += step;
   }
   return *this;
 }
 
 String operator*(const String& first, size_t n) {
-  String temp = first;
+  ALLOC_STATS_SCOPE("String", "operator*");
+  String temp(first, first.resource_);
   temp *= n;
   return temp;
 }
 
 std::istream& operator>>(std::istream& is, String& other) {
-  char input[kMax];
-  is >> input;
-  String temp(input);
-  other.Swap(temp);
+  ALLOC_STATS_SCOPE("String", "operator>>");
+  std::istream::sentry sentry(is);
+  if (!sentry) {
+    return is;
+  }
+  using Traits = std::istream::traits_type;
+  const auto& ctype = std::use_facet<std::ctype<char>>(is.getloc());
+  std::streambuf* buf = is.rdbuf();
+  size_t limit = is.width() > 0 ? static_cast<size_t>(is.width()) : kNpos;
+  is.width(0);
+  other.Clear();
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  Traits::int_type c = buf->sgetc();
+  while (other.size_ < limit) {
+    if (Traits::eq_int_type(c, Traits::eof())) {
+      state |= std::ios_base::eofbit;
+      break;
+    }
+    if (ctype.is(std::ctype_base::space, Traits::to_char_type(c))) {
+      break;
+    }
+    other.PushBack(Traits::to_char_type(c));
+    c = buf->snextc();
+  }
+  if (other.Empty()) {
+    state |= std::ios_base::failbit;
+  }
+  is.setstate(state);
+  return is;
+}
+
+std::istream& GetLine(std::istream& is, String& other, char delim) {
+  ALLOC_STATS_SCOPE("String", "GetLine");
+  std::istream::sentry sentry(is, true);
+  if (!sentry) {
+    return is;
+  }
+  using Traits = std::istream::traits_type;
+  std::streambuf* buf = is.rdbuf();
+  other.Clear();
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  bool extracted = false;
+  Traits::int_type c = buf->sgetc();
+  while (true) {
+    if (Traits::eq_int_type(c, Traits::eof())) {
+      state |= std::ios_base::eofbit;
+      break;
+    }
+    extracted = true;
+    if (Traits::to_char_type(c) == delim) {
+      buf->sbumpc();
+      break;
+    }
+    other.PushBack(Traits::to_char_type(c));
+    c = buf->snextc();
+  }
+  if (!extracted) {
+    state |= std::ios_base::failbit;
+  }
+  is.setstate(state);
   return is;
 }
 
+// Goes through std::string_view so that width, fill and adjustfield apply
+// as they do for std::string.
 std::ostream& operator<<(std::ostream& os, const String& other) {
-  for (size_t i = 0; i < other.Size(); ++i) {
-    os << other[i];
+  return os << std::string_view(other.str_, other.size_);
+}
+
+size_t String::Find(StringView needle, size_t pos) const {
+  return StringView(*this).Find(needle, pos);
+}
+
+size_t String::Find(char character, size_t pos) const {
+  return StringView(*this).Find(character, pos);
+}
+
+size_t String::RFind(StringView needle, size_t pos) const {
+  return StringView(*this).RFind(needle, pos);
+}
+
+size_t String::RFind(char character, size_t pos) const {
+  return StringView(*this).RFind(character, pos);
+}
+
+size_t String::FindFirstOf(StringView chars, size_t pos) const {
+  return StringView(*this).FindFirstOf(chars, pos);
+}
+
+size_t String::Count(StringView needle) const {
+  return StringView(*this).Count(needle);
+}
+
+String& String::Trim() { return TrimRight().TrimLeft(); }
+
+String& String::TrimLeft() {
+  StringView rest = StringView(*this).TrimLeft();
+  if (rest.Size() < size_) {
+    memmove(str_, rest.Data(), rest.Size());
+    size_ = rest.Size();
   }
-  return os;
+  return *this;
+}
+
+String& String::TrimRight() {
+  size_ = StringView(*this).TrimRight().Size();
+  return *this;
+}
+
+String& String::ToLowerAscii() {
+  size_t i = 0;
+  for (; i + kLanes <= size_; i += kLanes) {
+    LowerBlock(str_ + i);
+  }
+  for (; i < size_; ++i) {
+    if (str_[i] >= 'A' && str_[i] <= 'Z') {
+      str_[i] += 'a' - 'A';
+    }
+  }
+  return *this;
+}
+
+std::optional<int64_t> String::ParseInt(int base) const {
+  return StringView(*this).ParseInt(base);
+}
+
+std::optional<double> String::ParseDouble() const {
+  return StringView(*this).ParseDouble();
+}
+
+std::vector<StringView> String::ParallelSplit(StringView delim,
+                                              size_t threads) const {
+  return StringView(*this).ParallelSplit(delim, threads);
 }
 
 std::vector<String> String::Split(const String& delim) const {
+  ALLOC_STATS_SCOPE("String", "Split");
+  std::vector<StringView> fields = StringView(*this).Split(delim);
   std::vector<String> res;
-  char* begin = str_;
-  char* end = nullptr;
-  while (end != str_ + size_) {
-    end = std::strstr(begin, delim.str_);
-    if (end == NULL) {
-      end = str_ + size_;
-    }
-    String temp(end - begin);
-    memcpy(temp.str_, begin, end - begin);
-    res.emplace_back(temp);
-    begin = end + delim.size_;
+  res.reserve(fields.size());
+  for (StringView field : fields) {
+    res.emplace_back(field.Data(), field.Size(), resource_);
   }
   return res;
 }
 
 String String::Join(const std::vector<String>& lines) const {
-  String res("");
-  for (size_t i = 0; i < lines.size(); ++i) {
-    res += lines[i];
-    if (i < lines.size() - 1) {
-      res += *this;
-    }
+  return Join<std::vector<String>>(lines);
+}
+
+char* String::CopyChars(char* dst, StringView src) {
+  if (src.Size() > 0) {
+    memcpy(dst, src.Data(), src.Size());
   }
-  return res;
+  return dst + src.Size();
 }
 
-String::~String() { delete[] str_; }
+String::~String() { Deallocate(); }
 
 void String::Clear() { size_ = 0; }
@@ -1,25 +1,103 @@
 #pragma once
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory_resource>
+#include <optional>
 #include <vector>
 
-const int kMax = 2000;
+#include "../alloc_stats/alloc_stats.hpp"
+
 const size_t kDefaultSize = 19;
+const size_t kNpos = static_cast<size_t>(-1);
+
+class String;
+
+class StringView {
+ public:
+  StringView();
+
+  StringView(const char*, size_t);
+
+  StringView(const char*);
+
+  StringView(const String&);
+
+  const char& operator[](size_t i) const;
+
+  bool Empty() const;
+
+  size_t Size() const;
+
+  const char* Data() const;
+
+  int Compare(StringView) const;
+
+  size_t Hash() const;
+
+  StringView Substr(size_t pos, size_t len = kNpos) const;
+
+  StringView Trim() const;
+
+  StringView TrimLeft() const;
+
+  StringView TrimRight() const;
+
+  std::optional<int64_t> ParseInt(int base = 10) const;
+
+  std::optional<double> ParseDouble() const;
+
+  size_t Find(StringView, size_t pos = 0) const;
+
+  size_t Find(char, size_t pos = 0) const;
+
+  size_t RFind(StringView, size_t pos = kNpos) const;
+
+  size_t RFind(char, size_t pos = kNpos) const;
+
+  size_t FindFirstOf(StringView, size_t pos = 0) const;
+
+  size_t Count(StringView) const;
+
+  std::vector<StringView> Split(StringView delim = " ") const;
+
+  std::vector<StringView> ParallelSplit(StringView delim,
+                                        size_t threads = 0) const;
+
+ private:
+  const char* str_;
+  size_t size_;
+};
 
 class String {
  public:
   String();
 
-  explicit String(size_t, char);
+  explicit String(std::pmr::memory_resource*);
+
+  explicit String(
+      size_t, char,
+      std::pmr::memory_resource* = std::pmr::get_default_resource());
+
+  String(const char*,
+         std::pmr::memory_resource* = std::pmr::get_default_resource());
 
-  String(const char*);
+  String(const char*, size_t,
+         std::pmr::memory_resource* = std::pmr::get_default_resource());
 
-  String(size_t);
+  String(size_t, std::pmr::memory_resource* = std::pmr::get_default_resource());
 
   String(const String&);
 
+  String(const String&, std::pmr::memory_resource*);
+
+  String(String&&) noexcept;
+
   String& operator=(const String& s);
 
+  String& operator=(String&& s);
+
   void PushBack(const char&);
 
   void PopBack();
@@ -56,6 +134,12 @@ class String {
 
   const char* Data() const;
 
+  std::pmr::memory_resource* Resource() const;
+
+  int Compare(StringView) const;
+
+  size_t Hash() const;
+
   friend bool operator<(const String&, const String&);
 
   friend bool operator>=(const String&, const String&);
@@ -80,10 +164,42 @@ class String {
 
   friend std::ostream& operator<<(std::ostream&, const String&);
 
+  friend std::istream& GetLine(std::istream&, String&, char delim);
+
+  size_t Find(StringView, size_t pos = 0) const;
+
+  size_t Find(char, size_t pos = 0) const;
+
+  size_t RFind(StringView, size_t pos = kNpos) const;
+
+  size_t RFind(char, size_t pos = kNpos) const;
+
+  size_t FindFirstOf(StringView, size_t pos = 0) const;
+
+  size_t Count(StringView) const;
+
+  String& Trim();
+
+  String& TrimLeft();
+
+  String& TrimRight();
+
+  String& ToLowerAscii();
+
+  std::optional<int64_t> ParseInt(int base = 10) const;
+
+  std::optional<double> ParseDouble() const;
+
   std::vector<String> Split(const String& delim = " ") const;
 
+  std::vector<StringView> ParallelSplit(StringView delim,
+                                        size_t threads = 0) const;
+
   String Join(const std::vector<String>&) const;
 
+  template <typename Range>
+  String Join(const Range&) const;
+
   ~String();
 
   void Clear();
@@ -92,4 +208,52 @@ class String {
   char* str_;
   size_t size_;
   size_t capacity_;
+  std::pmr::memory_resource* resource_;
+
+  char* Allocate(size_t);
+
+  void Reallocate(size_t);
+
+  void Deallocate();
+
+  static char* CopyChars(char*, StringView);
+};
+
+std::istream& GetLine(std::istream&, String&, char delim = '\n');
+
+namespace std {
+template <>
+struct hash<String> {
+  size_t operator()(const String& s) const { return s.Hash(); }
+};
+
+template <>
+struct hash<StringView> {
+  size_t operator()(StringView s) const { return s.Hash(); }
 };
+}  // namespace std
+
+template <typename Range>
+String String::Join(const Range& lines) const {
+  ALLOC_STATS_SCOPE("String", "Join");
+  size_t count = 0;
+  size_t total = 0;
+  for (const auto& line : lines) {
+    total += StringView(line).Size();
+    ++count;
+  }
+  if (count > 1) {
+    total += (count - 1) * size_;
+  }
+  String res(total, resource_);
+  char* dst = res.str_;
+  bool first = true;
+  for (const auto& line : lines) {
+    if (!first) {
+      dst = CopyChars(dst, *this);
+    }
+    first = false;
+    dst = CopyChars(dst, line);
+  }
+  return res;
+}
@@ -0,0 +1,76 @@
+#include "string_pool.hpp"
+
+#include <mutex>
+
+StringPool::StringPool() : size_(0) {
+  for (auto& segment : segments_) {
+    segment.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+StringPool::~StringPool() {
+  for (auto& segment : segments_) {
+    delete[] segment.load(std::memory_order_relaxed);
+  }
+}
+
+StringPool::Handle StringPool::Intern(StringView s) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = index_.find(s);
+    if (it != index_.end()) {
+      return it->second;
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto it = index_.find(s);
+  if (it != index_.end()) {
+    return it->second;
+  }
+  size_t handle = size_.load(std::memory_order_relaxed);
+  if (handle >= kInvalidHandle) {
+    throw std::length_error("string pool is full");
+  }
+  char* copy = static_cast<char*>(arena_.allocate(s.Size() + 1, 1));
+  if (s.Size() > 0) {
+    memcpy(copy, s.Data(), s.Size());
+  }
+  copy[s.Size()] = '\0';
+  StringView stored(copy, s.Size());
+
+  size_t segment = SegmentOf(handle);
+  StringView* entries = segments_[segment].load(std::memory_order_relaxed);
+  if (entries == nullptr) {
+    entries = new StringView[kFirstSegment << segment];
+    segments_[segment].store(entries, std::memory_order_release);
+  }
+  entries[handle - SegmentBegin(segment)] = stored;
+  index_.emplace(stored, static_cast<Handle>(handle));
+  size_.store(handle + 1, std::memory_order_release);
+  return static_cast<Handle>(handle);
+}
+
+StringPool::Handle StringPool::Find(StringView s) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto it = index_.find(s);
+  return it == index_.end() ? kInvalidHandle : it->second;
+}
+
+StringView StringPool::View(Handle handle) const {
+  size_t segment = SegmentOf(handle);
+  const StringView* entries = segments_[segment].load(std::memory_order_acquire);
+  return entries[handle - SegmentBegin(segment)];
+}
+
+size_t StringPool::Size() const {
+  return size_.load(std::memory_order_acquire);
+}
+
+size_t StringPool::SegmentOf(Handle handle) {
+  size_t blocks = handle / kFirstSegment + 1;
+  return 63 - __builtin_clzll(blocks);
+}
+
+size_t StringPool::SegmentBegin(size_t segment) {
+  return kFirstSegment * ((static_cast<size_t>(1) << segment) - 1);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "string.hpp"
+
+class StringPool {
+ public:
+  using Handle = uint32_t;
+
+  static constexpr Handle kInvalidHandle = static_cast<Handle>(-1);
+
+  StringPool();
+
+  StringPool(const StringPool&) = delete;
+
+  StringPool& operator=(const StringPool&) = delete;
+
+  ~StringPool();
+
+  Handle Intern(StringView);
+
+  Handle Find(StringView) const;
+
+  StringView View(Handle) const;
+
+  size_t Size() const;
+
+ private:
+  struct ViewEqual {
+    bool operator()(StringView first, StringView second) const {
+      return first.Compare(second) == 0;
+    }
+  };
+
+  static const size_t kFirstSegment = 64;
+  static const size_t kSegments = 27;
+
+  // Handle -> view table split into segments of doubling size, so readers
+  // never see a reallocation and View() needs no lock.
+  std::atomic<StringView*> segments_[kSegments];
+  std::atomic<size_t> size_;
+
+  std::unordered_map<StringView, Handle, std::hash<StringView>, ViewEqual>
+      index_;
+  std::pmr::monotonic_buffer_resource arena_;
+  mutable std::shared_mutex mutex_;
+
+  static size_t SegmentOf(Handle);
+
+  static size_t SegmentBegin(size_t);
+};
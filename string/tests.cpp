@@ -1,7 +1,15 @@
+#include "mapped_string.hpp"
+#include "rope.hpp"
+#include "shared_string.hpp"
 #include "string.hpp"
+#include "string_pool.hpp"
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <iomanip>
 #include <random>
+#include <thread>
+#include <unordered_map>
 
 TEST(Constructors, Default) {
   String s;
@@ -267,6 +275,50 @@ TEST(Comparison, Empty) {
   EXPECT_TRUE(t != s);
 }
 
+TEST(Comparison, Compare) {
+  EXPECT_LT(String("abc").Compare("abd"), 0);
+  EXPECT_GT(String("abd").Compare("abc"), 0);
+  EXPECT_LT(String("ab").Compare("abc"), 0);
+  EXPECT_GT(String("abc").Compare(""), 0);
+  EXPECT_EQ(String("abc").Compare("abc"), 0);
+  EXPECT_EQ(String().Compare(""), 0);
+}
+
+TEST(Comparison, NotTerminated) {
+  String s = "ab";
+  s.PushBack('c');
+  String t = "ab";
+  t.PushBack('d');
+  EXPECT_TRUE(s < t);
+  EXPECT_TRUE(t > s);
+  EXPECT_TRUE(s != t);
+  t.PopBack();
+  t.PushBack('c');
+  EXPECT_TRUE(s == t);
+  EXPECT_FALSE(s != t);
+}
+
+TEST(Hash, UnorderedMap) {
+  std::unordered_map<String, size_t> counts;
+  std::vector<String> words = String("a bb a ccc bb a").Split();
+  for (const String& word : words) {
+    ++counts[word];
+  }
+  EXPECT_EQ(counts.size(), 3);
+  EXPECT_EQ(counts[String("a")], 3);
+  EXPECT_EQ(counts[String("bb")], 2);
+  EXPECT_EQ(counts[String("ccc")], 1);
+  for (size_t len = 0; len < 200; ++len) {
+    String a(len, 'x');
+    String b(len, 'x');
+    ASSERT_EQ(a.Hash(), b.Hash());
+    if (len > 0) {
+      b.Back() = 'y';
+      ASSERT_NE(a.Hash(), b.Hash());
+    }
+  }
+}
+
 TEST(Iostream, In) {
   std::stringstream is{"olololo"};
   String s;
@@ -274,6 +326,31 @@ TEST(Iostream, In) {
   ASSERT_EQ(s, String("olololo"));
 }
 
+TEST(Iostream, InLong) {
+  std::string token(100000, 'x');
+  std::stringstream is{"  " + token + "\n next"};
+  String s;
+  String t;
+  is >> s >> t;
+  ASSERT_EQ(s.Size(), token.size());
+  ASSERT_TRUE(s == token.c_str());
+  ASSERT_TRUE(t == "next");
+  ASSERT_FALSE(is >> s);
+}
+
+TEST(Iostream, GetLine) {
+  std::stringstream is{"first line\n\nlast"};
+  String s;
+  ASSERT_TRUE(GetLine(is, s));
+  ASSERT_TRUE(s == "first line");
+  ASSERT_TRUE(GetLine(is, s));
+  ASSERT_TRUE(s.Empty());
+  ASSERT_TRUE(GetLine(is, s));
+  ASSERT_TRUE(s == "last");
+  ASSERT_TRUE(is.eof());
+  ASSERT_FALSE(GetLine(is, s));
+}
+
 TEST(Iostream, Out) {
   std::stringstream os;
   String s = "lol";
@@ -288,6 +365,22 @@ TEST(Iostream, ConstOut) {
   ASSERT_EQ(os.str(), "lol");
 }
 
+TEST(Iostream, OutPadding) {
+  const String s = "lol";
+  for (bool left : {false, true}) {
+    std::stringstream os;
+    std::stringstream expected;
+    if (left) {
+      os << std::left;
+      expected << std::left;
+    }
+    os << std::setw(6) << std::setfill('*') << s << '|' << s;
+    expected << std::setw(6) << std::setfill('*') << std::string("lol")
+             << '|' << std::string("lol");
+    ASSERT_EQ(os.str(), expected.str());
+  }
+}
+
 TEST(Concat, EasyPlus) {
   String s = "aboba";
   String t = "biba";
@@ -354,6 +447,16 @@ TEST(Multiply, Const) {
 TEST(Multiply, Stress) {
   String s = "a";
   EXPECT_TRUE(s * 1000000 == String(1000000, 'a'));
+
+  const String chunk = "abc";
+  const size_t times = (1 << 24) + 3;
+  String res = chunk * times;
+  ASSERT_EQ(res.Size(), chunk.Size() * times);
+  ASSERT_EQ(res.Capacity(), res.Size());
+  for (size_t i = 0; i < res.Size(); i += 4099) {
+    ASSERT_EQ(res[i], chunk[i % chunk.Size()]);
+  }
+  ASSERT_EQ(res.Back(), 'c');
 }
 
 TEST(Multiply, Assignment) {
@@ -404,6 +507,128 @@ TEST(Split, SomeTests) {
   }
 }
 
+TEST(Find, Easy) {
+  String s = "abacaba";
+  EXPECT_EQ(s.Find("aca"), 2);
+  EXPECT_EQ(s.Find("aba", 1), 4);
+  EXPECT_EQ(s.Find("abd"), kNpos);
+  EXPECT_EQ(s.Find('c'), 3);
+  EXPECT_EQ(s.Find(""), 0);
+  EXPECT_EQ(s.Find("", 7), 7);
+  EXPECT_EQ(s.Find("a", 8), kNpos);
+  EXPECT_EQ(String().Find("a"), kNpos);
+}
+
+TEST(Find, RFind) {
+  String s = "abacaba";
+  EXPECT_EQ(s.RFind("aba"), 4);
+  EXPECT_EQ(s.RFind("aba", 3), 0);
+  EXPECT_EQ(s.RFind('c'), 3);
+  EXPECT_EQ(s.RFind('b', 4), 1);
+  EXPECT_EQ(s.RFind("abd"), kNpos);
+  EXPECT_EQ(s.RFind(""), 7);
+}
+
+TEST(Find, FirstOf) {
+  String s = "key=value;next";
+  EXPECT_EQ(s.FindFirstOf("=;"), 3);
+  EXPECT_EQ(s.FindFirstOf("=;", 4), 9);
+  EXPECT_EQ(s.FindFirstOf("!@#%^&"), kNpos);
+  EXPECT_EQ(s.FindFirstOf(""), kNpos);
+}
+
+TEST(Find, Count) {
+  EXPECT_EQ(String("aaaa").Count("aa"), 2);
+  EXPECT_EQ(String("abacaba").Count("a"), 4);
+  EXPECT_EQ(String("abc").Count(""), 4);
+  EXPECT_EQ(String("abc").Count("d"), 0);
+}
+
+TEST(Find, Stress) {
+  std::mt19937 gen(1337);
+  std::uniform_int_distribution<> letter(0, 2);
+  std::string hay_s;
+  for (size_t i = 0; i < 5000; ++i) {
+    hay_s.push_back('a' + letter(gen));
+  }
+  String hay = hay_s.c_str();
+  std::uniform_int_distribution<size_t> pos(0, hay_s.size());
+  for (size_t len : {1, 2, 3, 7, 16, 31, 32, 33, 64, 100}) {
+    for (size_t i = 0; i < 50; ++i) {
+      size_t from = pos(gen);
+      std::string needle_s = hay_s.substr(from, len);
+      if (i % 2 == 1 && !needle_s.empty()) {
+        needle_s.back() = 'a' + letter(gen);
+      }
+      String needle = needle_s.c_str();
+      size_t start = pos(gen);
+      ASSERT_EQ(hay.Find(needle, start), hay_s.find(needle_s, start));
+      ASSERT_EQ(hay.RFind(needle, start), hay_s.rfind(needle_s, start));
+    }
+  }
+  ASSERT_EQ(hay.FindFirstOf("cb", 100), hay_s.find_first_of("cb", 100));
+}
+
+TEST(Split, Parallel) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<> letter(0, 3);
+  String text;
+  text.Reserve(1 << 23);
+  for (size_t i = 0; i < (1 << 23); ++i) {
+    text.PushBack(letter(gen) == 0 ? ',' : 'a' + letter(gen));
+  }
+  for (const char* delim : {",", "aa", "a,b", ",,,"}) {
+    std::vector<StringView> parallel = text.ParallelSplit(delim, 4);
+    std::vector<String> sequential = text.Split(delim);
+    ASSERT_EQ(parallel.size(), sequential.size());
+    for (size_t i = 0; i < parallel.size(); ++i) {
+      ASSERT_EQ(sequential[i].Compare(parallel[i]), 0);
+    }
+  }
+  ASSERT_EQ(String("a,b").ParallelSplit(",", 4).size(), 2);
+
+  String odd_chunks(4 * ((1 << 20) + 1), 'a');
+  std::vector<StringView> parts = odd_chunks.ParallelSplit("aa", 4);
+  ASSERT_EQ(parts.size(), odd_chunks.Size() / 2 + 1);
+  ASSERT_EQ(parts[1].Data(), odd_chunks.Data() + 2);
+}
+
+TEST(Fields, Trim) {
+  String s = " \t value \r\n";
+  EXPECT_EQ(StringView(s).Trim().Compare("value"), 0);
+  EXPECT_EQ(StringView(s).TrimLeft().Compare("value \r\n"), 0);
+  const char* data = s.Data();
+  s.Trim();
+  EXPECT_TRUE(s == "value");
+  EXPECT_EQ(s.Data(), data);
+  String blank = "   ";
+  EXPECT_TRUE(blank.Trim().Empty());
+  EXPECT_TRUE(String().Trim().Empty());
+}
+
+TEST(Fields, ToLowerAscii) {
+  String s = "Hello, WORLD! \xC0\xDF Zz@[`{";
+  s.ToLowerAscii();
+  EXPECT_TRUE(s == "hello, world! \xC0\xDF zz@[`{");
+  String long_s = String("AbCxYZ09") * 100;
+  long_s.ToLowerAscii();
+  EXPECT_TRUE(long_s == String("abcxyz09") * 100);
+}
+
+TEST(Fields, Parse) {
+  std::vector<String> fields = String("42, -17 ,3.5,abc,,1e3,99x").Split(",");
+  EXPECT_EQ(StringView(fields[0]).ParseInt(), 42);
+  EXPECT_EQ(StringView(fields[1]).Trim().ParseInt(), -17);
+  EXPECT_FALSE(fields[1].ParseInt().has_value());
+  EXPECT_EQ(fields[2].ParseDouble(), 3.5);
+  EXPECT_FALSE(fields[3].ParseInt().has_value());
+  EXPECT_FALSE(fields[4].ParseDouble().has_value());
+  EXPECT_EQ(fields[5].ParseDouble(), 1000.0);
+  EXPECT_FALSE(fields[6].ParseInt().has_value());
+  EXPECT_EQ(String("ff").ParseInt(16), 255);
+  EXPECT_FALSE(String("99999999999999999999").ParseInt().has_value());
+}
+
 TEST(Join, Easy) {
   EXPECT_TRUE(String("aba") == String("b").Join({"a", "a"}));
 }
@@ -422,6 +647,226 @@ TEST(Join, Stress) {
   EXPECT_TRUE(expected == b.Join({a, a}).Join({c, c}));
 }
 
+TEST(Join, SingleAllocation) {
+  std::vector<String> lines{"ab", "", "cde", "f"};
+  String res = String(", ").Join(lines);
+  EXPECT_TRUE(res == "ab, , cde, f");
+  EXPECT_EQ(res.Capacity(), res.Size());
+}
+
+TEST(Join, Views) {
+  String text = "one two three";
+  std::vector<StringView> views{StringView(text.Data(), 3),
+                                StringView(text.Data() + 4, 3), "four"};
+  EXPECT_TRUE(String("-").Join(views) == "one-two-four");
+  const char* raw[] = {"x", "y", "z"};
+  EXPECT_TRUE(String("").Join(raw) == "xyz");
+}
+
+TEST(Allocator, Arena) {
+  char buffer[1 << 12];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  auto in_arena = [&buffer](const String& s) {
+    return s.Data() >= buffer && s.Data() < buffer + sizeof(buffer);
+  };
+  String line("a,bb,ccc", &arena);
+  ASSERT_EQ(line.Resource(), &arena);
+  ASSERT_TRUE(in_arena(line));
+
+  std::vector<String> parts = line.Split(",");
+  ASSERT_EQ(parts.size(), 3);
+  for (const String& part : parts) {
+    ASSERT_EQ(part.Resource(), &arena);
+    ASSERT_TRUE(in_arena(part));
+  }
+  String joined = String(";", &arena).Join(parts);
+  ASSERT_EQ(joined.Resource(), &arena);
+  ASSERT_TRUE(in_arena(joined));
+  ASSERT_TRUE(joined == "a;bb;ccc");
+
+  String copy = joined;
+  ASSERT_EQ(copy.Resource(), std::pmr::get_default_resource());
+  String moved = std::move(joined);
+  ASSERT_EQ(moved.Resource(), &arena);
+  ASSERT_TRUE(moved == "a;bb;ccc");
+}
+
+TEST(Rope, Concat) {
+  Rope rope = Rope("hello") + Rope(", ") + Rope(String("world"));
+  ASSERT_EQ(rope.Size(), 12);
+  ASSERT_EQ(rope[7], 'w');
+  ASSERT_TRUE(rope.Flatten() == "hello, world");
+  ASSERT_TRUE(rope.Substr(3, 6).Flatten() == "lo, wo");
+  ASSERT_TRUE(Rope().Flatten().Empty());
+}
+
+TEST(Rope, Chunks) {
+  String big(1000, 'x');
+  Rope rope;
+  for (size_t i = 0; i < 10; ++i) {
+    rope += big;
+  }
+  size_t chunks = 0;
+  size_t total = 0;
+  for (auto it = rope.ChunkBegin(); it != rope.ChunkEnd(); ++it) {
+    ++chunks;
+    total += it->Size();
+  }
+  ASSERT_EQ(chunks, 10);
+  ASSERT_EQ(total, rope.Size());
+  std::stringstream os;
+  os << rope;
+  ASSERT_EQ(os.str(), std::string(10000, 'x'));
+}
+
+TEST(Rope, Stress) {
+  std::mt19937 gen(42);
+  std::string expected;
+  Rope rope;
+  for (size_t i = 0; i < 2000; ++i) {
+    std::uniform_int_distribution<size_t> pos(0, expected.size());
+    size_t at = pos(gen);
+    if (i % 3 == 2) {
+      size_t len = pos(gen) % 50;
+      expected.erase(at, len);
+      rope.Erase(at, len);
+    } else {
+      std::string piece(1 + gen() % 300, 'a' + i % 26);
+      expected.insert(at, piece);
+      rope.Insert(at, Rope(piece.c_str()));
+    }
+    ASSERT_EQ(rope.Size(), expected.size());
+  }
+  String flat = rope.Flatten();
+  ASSERT_TRUE(flat == expected.c_str());
+  size_t from = expected.size() / 3;
+  ASSERT_TRUE(rope.Substr(from, 777).Flatten() ==
+              expected.substr(from, 777).c_str());
+}
+
+TEST(MappedString, Read) {
+  std::string path = testing::TempDir() + "mapped_string_read.txt";
+  {
+    std::ofstream out(path);
+    out << "id,name,value\n1,alpha,10\n2,beta,20\n";
+  }
+  MappedString file(path.c_str());
+  ASSERT_EQ(file.Size(), 35);
+  ASSERT_EQ(file.Front(), 'i');
+  ASSERT_EQ(file.Find("beta"), 27);
+  ASSERT_EQ(file.Count("\n"), 3);
+  std::vector<StringView> lines = file.Split("\n");
+  ASSERT_EQ(lines.size(), 4);
+  ASSERT_TRUE(String(lines[1].Data(), lines[1].Size()) == "1,alpha,10");
+  ASSERT_EQ(lines[1].Data(), file.Data() + 14);
+  ASSERT_TRUE(lines[3].Empty());
+  std::remove(path.c_str());
+}
+
+TEST(MappedString, EmptyAndMissing) {
+  std::string path = testing::TempDir() + "mapped_string_empty.txt";
+  std::ofstream(path).close();
+  MappedString file(path.c_str());
+  ASSERT_TRUE(file.Empty());
+  ASSERT_EQ(file.Find("x"), kNpos);
+  std::remove(path.c_str());
+  ASSERT_THROW(MappedString(path.c_str()), std::system_error);
+}
+
+TEST(SharedString, Copies) {
+  String payload(1000, 'p');
+  SharedString shared(payload);
+  ASSERT_EQ(shared.UseCount(), 1);
+  SharedString copy = shared;
+  ASSERT_EQ(copy.Data(), shared.Data());
+  ASSERT_EQ(shared.UseCount(), 2);
+  ASSERT_TRUE(copy.ToString() == payload);
+  SharedString moved = std::move(copy);
+  ASSERT_EQ(shared.UseCount(), 2);
+  ASSERT_TRUE(copy.Empty());
+  ASSERT_TRUE(moved == shared);
+  ASSERT_TRUE(SharedString("abc") != SharedString("abd"));
+  ASSERT_EQ(SharedString("").Size(), 0);
+}
+
+TEST(SharedString, FanOut) {
+  SharedString shared("payload");
+  std::vector<std::thread> consumers;
+  for (size_t i = 0; i < 4; ++i) {
+    consumers.emplace_back([shared] {
+      for (size_t j = 0; j < 10000; ++j) {
+        SharedString local = shared;
+        ASSERT_EQ(local.Size(), 7);
+      }
+    });
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  ASSERT_EQ(shared.UseCount(), 1);
+}
+
+TEST(StringPool, Intern) {
+  StringPool pool;
+  std::vector<String> tokens = String("GET /a GET /b POST /a").Split();
+  std::vector<StringPool::Handle> handles;
+  for (const String& token : tokens) {
+    handles.push_back(pool.Intern(token));
+  }
+  ASSERT_EQ(pool.Size(), 4);
+  ASSERT_EQ(handles[0], handles[2]);
+  ASSERT_EQ(handles[1], handles[5]);
+  ASSERT_NE(handles[0], handles[4]);
+  ASSERT_EQ(pool.View(handles[4]).Compare("POST"), 0);
+  ASSERT_EQ(pool.Find("/b"), handles[3]);
+  ASSERT_EQ(pool.Find("PUT"), StringPool::kInvalidHandle);
+  ASSERT_EQ(pool.Intern(""), pool.Intern(StringView()));
+}
+
+TEST(StringPool, Concurrent) {
+  StringPool pool;
+  const size_t distinct = 5000;
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < 4; ++t) {
+    workers.emplace_back([&pool, distinct, t] {
+      for (size_t i = 0; i < distinct; ++i) {
+        std::string token = std::to_string((i * 7 + t) % distinct);
+        StringPool::Handle handle = pool.Intern(token.c_str());
+        ASSERT_EQ(pool.View(handle).Compare(token.c_str()), 0);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  ASSERT_EQ(pool.Size(), distinct);
+}
+
+TEST(AllocStats, Counters) {
+  String text = "a,b,c";
+  AllocStats::Reset();
+  std::vector<String> fields = text.Split(",");
+  String copy = fields[0];
+  for (size_t i = 0; i < 100; ++i) {
+    copy.PushBack('x');
+  }
+#ifdef ALLOC_STATS
+  AllocCounters split = AllocStats::Get("String", "Split");
+  ASSERT_EQ(split.allocations, 3);
+  ASSERT_EQ(split.bytes, 6);
+  ASSERT_EQ(split.copies, 0);
+  ASSERT_EQ(AllocStats::Get("String", "other").copies, 1);
+  AllocCounters push = AllocStats::Get("String", "PushBack");
+  ASSERT_EQ(push.reallocations, push.allocations);
+  ASSERT_GT(push.reallocations, 0);
+  ASSERT_LT(push.reallocations, 10);
+  AllocStats::Reset();
+  ASSERT_TRUE(AllocStats::Snapshot().empty());
+#else
+  ASSERT_TRUE(AllocStats::Snapshot().empty());
+#endif
+}
 
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);